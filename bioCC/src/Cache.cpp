@@ -0,0 +1,96 @@
+/**********************************************************
+Cache.cpp
+Provides the means of the binary sidecar cache of the inner representation
+2026 Fedor Naumenko (fedor.naumenko@gmail.com)
+Last modified: 10/17/2026
+***********************************************************/
+
+#include "Cache.h"
+#include "ChromData.h"
+#include <sys/stat.h>
+#include <thread>
+#ifdef OS_Windows
+	#define NOMINMAX
+	#include <windows.h>
+	#include <process.h>	// _getpid
+	#define getpid _getpid
+#else
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+/************************ class MappedFile ************************/
+
+MappedFile::MappedFile(const string& fName)
+{
+#ifdef OS_Windows
+	HANDLE hFile = CreateFileA(fName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)	return;
+	_hFile = hFile;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size) || !size.QuadPart)	return;
+	if (!(_hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL)))	return;
+	if (_data = (const BYTE*)MapViewOfFile(_hMap, FILE_MAP_READ, 0, 0, 0))
+		_size = size_t(size.QuadPart);
+#else
+	if ((_fd = open(fName.c_str(), O_RDONLY)) < 0)	return;
+	struct stat st;
+	if (fstat(_fd, &st) || !st.st_size)	return;
+	void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, _fd, 0);
+	if (data == MAP_FAILED)	return;
+	_data = (const BYTE*)data;
+	_size = size_t(st.st_size);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef OS_Windows
+	if (_data)	UnmapViewOfFile(_data);
+	if (_hMap)	CloseHandle(_hMap);
+	if (_hFile)	CloseHandle(_hFile);
+#else
+	if (_data)	munmap((void*)_data, _size);
+	if (_fd >= 0)	close(_fd);
+#endif
+}
+
+/************************ end of class MappedFile ************************/
+
+// Initializes key by the source file
+//	@fName: source file name
+//	@cSizes: chrom sizes
+//	@dupl: duplicates permission, or 0 if not applicable
+//	return: false if source file is not accessible
+bool CacheKey::Init(const char* fName, const ChromSizes& cSizes, BYTE dupl)
+{
+	struct stat st;
+
+	if (stat(fName, &st))	return false;
+	SrcSize = genlen(st.st_size);
+	SrcTime = (long long)st.st_mtime * 1000000000;
+#if defined(__APPLE__)
+	SrcTime += st.st_mtimespec.tv_nsec;
+#elif !defined(OS_Windows)
+	SrcTime += st.st_mtim.tv_nsec;
+#endif
+	// FNV-1a hash: the same genome size does not mean the same chroms
+	ChromsHash = 14695981039346656037ULL;
+	for (auto it = cSizes.cBegin(); it != cSizes.cEnd(); it++)
+		for (const unsigned long long val : { (unsigned long long)CID(it), (unsigned long long)cSizes[CID(it)] })
+			for (BYTE i = 0; i < sizeof(val); i++)
+				ChromsHash = (ChromsHash ^ BYTE(val >> 8 * i)) * 1099511628211ULL;
+	Dupl = dupl;
+	UserCID = Chrom::UserCID();
+	return true;
+}
+
+// Returns temporary file name unique for the process and thread
+//	@fName: final file name
+string CacheKey::TmpFileName(const string& fName)
+{
+	return fName + '.' + to_string(getpid()) + '.'
+		+ to_string(hash<thread::id>()(this_thread::get_id())) + ".tmp";
+}
@@ -0,0 +1,73 @@
+/**********************************************************
+Cache.h
+Provides the means of the binary sidecar cache of the inner representation
+2026 Fedor Naumenko (fedor.naumenko@gmail.com)
+Last modified: 10/17/2026
+***********************************************************/
+#pragma once
+
+#include "common.h"
+
+class ChromSizes;
+
+// 'MappedFile' represents read-only file mapped into memory
+class MappedFile
+{
+	const BYTE* _data = nullptr;	// mapped data
+	size_t		_size = 0;			// size of data
+#ifdef OS_Windows
+	void*	_hFile = nullptr;		// file handle
+	void*	_hMap = nullptr;		// mapping handle
+#else
+	int		_fd = -1;				// file descriptor
+#endif
+
+public:
+	// Maps existing file into memory; invalid instance is created if file cannot be mapped
+	//	@fName: file name
+	MappedFile(const string& fName);
+
+	~MappedFile();
+
+	// Returns true if file is mapped
+	bool IsValid() const { return _data; }
+
+	// Returns mapped data
+	const BYTE* Data() const { return _data; }
+
+	// Returns size of mapped data
+	size_t Size() const { return _size; }
+};
+
+// 'CacheKey' identifies the source file and the options by which the inner representation was built
+struct CacheKey
+{
+	genlen		SrcSize = 0;	// source file size
+	long long	SrcTime = 0;	// source file modification time in nanoseconds, if the platform provides them
+	unsigned long long ChromsHash = 0;	// hash of the chrom IDs and lengths
+	BYTE		Dupl = 0;		// duplicates permission
+	chrid		UserCID = 0;	// user-defined chrom
+	bool		ReadCov = false;	// true for the coverage by reads or fragments
+	chrlen		FragLen = 0;	// length to which reads are extended for the coverage
+
+	// Initializes key by the source file
+	//	@fName: source file name
+	//	@cSizes: chrom sizes
+	//	@dupl: duplicates permission, or 0 if not applicable
+	//	return: false if source file is not accessible
+	bool Init(const char* fName, const ChromSizes& cSizes, BYTE dupl);
+
+	bool operator==(const CacheKey& key) const {
+		return SrcSize == key.SrcSize && SrcTime == key.SrcTime && ChromsHash == key.ChromsHash
+			&& Dupl == key.Dupl && UserCID == key.UserCID
+			&& ReadCov == key.ReadCov && FragLen == key.FragLen;
+	}
+
+	// Returns cache file name for the source file
+	//	@fName: source file name
+	static string FileName(const char* fName) { return string(fName) + ".bcc"; }
+
+	// Returns temporary file name unique for the process and thread
+	//	@fName: final file name
+	static string TmpFileName(const string& fName);
+};
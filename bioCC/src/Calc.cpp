@@ -2,23 +2,42 @@
 Calc.ccp
 Provides classes for calculating CC
 2014 Fedor Naumenko (fedor.naumenko@gmail.com)
-Last modified: 07/31/2024
+Last modified: 10/17/2026
 ***********************************************************/
 
 #include "Calc.h"
 #include "ChromData.h"
+#include "Workers.h"
 #include <algorithm>    // std::sort
+#include <future>
+#include <deque>
+#include <unordered_map>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define _SIMD_DISPATCH		// the instructions summing the bins are chosen at run time
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define SIMD_TARGET(arch)	// MSVC provides the intrinsics regardless of the target
+	#else
+		#define SIMD_TARGET(arch) __attribute__((target(arch)))
+	#endif
+#endif
 
 const string sFormat = " format";
 const char* sUNDEF = "UNDEF";
 const int Undef = -3;	// undefined coefficient
 
 // Prints PCC
-void PrintR(float cc) 
+//	@cc: correlation coefficient
+//	@dev: bound of the coefficient deviation, or negative if coefficient is exact
+void PrintR(float cc, float dev = -1) 
 {
 	dout << left << setw(12) << setfill(SPACE);
 	if(cc == Undef || isNaN(cc))	dout << sUNDEF;
-	else	dout << cc;
+	else {
+		dout << cc;
+		if (dev >= 0)	dout << "+-" << dev;
+	}
 	dout << LF;
 }
 
@@ -70,7 +89,8 @@ void PrintMngr::CompleteEmpty(const char* fName, FT::eType type)
 // Prints PCC
 //	@cc: correlation coefficient
 //	@cID: calculated chrom pcc or total
-void PrintMngr::PrintCC(float cc, chrid cID)
+//	@dev: bound of the coefficient deviation, or negative if coefficient is exact
+void PrintMngr::PrintCC(float cc, chrid cID, float dev)
 {
 	if (cID == Chrom::UnID) {	// total CC
 		if (_OInfo > eOInfo::LAC || IsPrintTotal())
@@ -79,7 +99,7 @@ void PrintMngr::PrintCC(float cc, chrid cID)
 	else						// chrom CC
 		dout << Chrom::AbbrName(cID) << TAB;
 
-	PrintR(cc);
+	PrintR(cc, dev);
 	fflush(stdout);		// when called from a package 
 }
 
@@ -108,583 +128,2601 @@ void PlainCover::AddChrom(chrlen cID, chrlen cLen, chrlen prevEnd)
 
 	// add chrom
 	const chrlen lastInd = chrlen(_items.size());
+	if (_sink) {		// streaming mode: pass chrom's items to the sink and release them
+		vector<ValPos> items;
+		const size_t first = _lastInd;
+
+		items.swap(_items);
+		_items.push_back(items.back());	// keep the last item for checking the next added one
+		_lastInd = 1;
+		_sunkCnt += lastInd - first;
+		(*_sink)(cID, move(items), first);
+		return;
+	}
 	AddVal(cID, ItemIndices(chrlen(_lastInd), lastInd));	// minus added 1 first and 2 last zero intervals
 										// !!! replace AddVal by emplace
 	_lastInd = lastInd;
 }
 
-// Sets new position and returns current len
-chrlen SetPos(chrlen& pos, chrlen currPos)
+// 'spR' - single-pass Pearson coefficient (R) calculater; keeps accumulates sums & calculates PCC
+class spR : public R
 {
-	const chrlen len = currPos - pos;
-	pos = currPos;
-	return len;
-}
+	double	_sumX = 0, _sumY = 0;		// sum of signal values
+	double	_sumXY = 0;					// sum of the products of the values of both signals
+	double	_sumSqrX = 0, _sumSqrY = 0;	// sum of squared signal values
+	genlen	_len = 0;
 
-// Calculates and prints corr. coefficients, using single-pass range-based algorithm
-//	@cv: compared cover
-//	@gRgns: def regions (chrom sizes)
-//	@templ: template to define treated regions
-//	return: true if calculation was actually done
-bool PlainCover::CalcR(const PlainCover& cv, const DefRegions& rgns, const Features* templ)
+public:
+	void Clear() { _sumX = _sumY = _sumXY = _sumSqrX = _sumSqrY = 0; _len = 0; }
+
+	// Adds accumulated sums of another calculater
+	void Add(const spR& r) {
+		_sumX += r._sumX;	_sumSqrX += r._sumSqrX;
+		_sumY += r._sumY;	_sumSqrY += r._sumSqrY;
+		_sumXY += r._sumXY;
+		_len += r._len;
+	}
+
+	// Adds range length and correlated range values
+	void AddVal(chrlen len, float valX, float valY) {
+		const double valXLen = double(valX) * len;
+		const double valYLen = double(valY) * len;
+
+		_sumX += valXLen;	_sumSqrX += valX * valXLen;
+		_sumY += valYLen;	_sumSqrY += valY * valYLen;
+		_sumXY += valXLen * valY;
+		_len += len;
+	}
+
+	// Adds sums accumulated outside
+	//	@len: total length of ranges
+	//	@sumX: sum of the first signal values
+	//	@sumSqrX: sum of the first signal squared values
+	//	@sumY: sum of the second signal values
+	//	@sumSqrY: sum of the second signal squared values
+	//	@sumXY: sum of the products of the values of both signals
+	void AddSums(genlen len, double sumX, double sumSqrX, double sumY, double sumSqrY, double sumXY) {
+		_sumX += sumX;	_sumSqrX += sumSqrX;
+		_sumY += sumY;	_sumSqrY += sumSqrY;
+		_sumXY += sumXY;
+		_len += len;
+	}
+
+	// Returnes Pearson CC
+	float PCC() {
+		return GetR(_len * _sumXY - _sumX * _sumY,
+			_len * _sumSqrX - _sumX * _sumX,
+			_len * _sumSqrY - _sumY * _sumY);
+	}
+
+	// Returns the bound of PCC deviation caused by the error of the sum of products;
+	// the other sums are supposed to be exact
+	//	@errXY: bound of the error of the sum of products
+	float Deviation(double errXY) const {
+		const double var = (_len * _sumSqrX - _sumX * _sumX) * (_len * _sumSqrY - _sumY * _sumY);
+		return var > 0 ? float(min(2.0, _len * errXY / sqrt(var))) : 0;
+	}
+};
+
+// 'FeatureR' represetns pair <feature-ID><feature-PCC>
+struct FeatureR : pair<chrlen, float>
 {
-	// 'spR' - single-pass Pearson coefficient (R) calculater; keeps accumulates sums & calculates PCC
-	class spR : public R
-	{
-		double	_sumX = 0, _sumY = 0;		// sum of signal values
-		double	_sumXY = 0;					// sum of the products of the values of both signals
-		double	_sumSqrX = 0, _sumSqrY = 0;	// sum of squared signal values
-		genlen	_len = 0;
+	inline FeatureR(chrlen id, float cc) { first = id; second = cc; }
 
-	public:
-		void Clear() { _sumX = _sumY = _sumXY = _sumSqrX = _sumSqrY = 0; _len = 0; }
+	inline bool operator < (const FeatureR& rccr) const { return second < rccr.second; }
 
-		// Adds range length and correlated range values
-		void AddVal(chrlen len, float valX, float valY) {
-			const double valXLen = double(valX) * len;
-			const double valYLen = double(valY) * len;
+	void Print() const { dout << first << TAB; PrintR(second); }
+};
 
-			_sumX += valXLen;	_sumSqrX += valX * valXLen;
-			_sumY += valYLen;	_sumSqrY += valY * valYLen;
-			_sumXY += valXLen * valY;
-			_len += len;
+// 'FeatureRs' represetns FeatureR collection, including methods to print collection and CC histogram
+class FeatureRs : vector<FeatureR>
+{
+	// Creates and prints histogram
+	void PrintHist(float binWidth)
+	{
+		// ** set abs values and sort
+		for (auto& i : *this)
+			if (i.second < 0)	i.second = -i.second;
+		sort(begin(), end());	// by increase
+		
+		// ** define factor - a divisor of binWidth: 0.1--0.9=>10, 0.01--0.09=>100 etc
+		short F = 10;
+		for (; binWidth * F < 1; F *= 10);
+
+		// ** define min scaled bin value
+		auto it = begin();
+		// then float instead of double because of wrong consolidation by round double
+		float minBin = float(int(it->second * F)) / F;
+		
+		// ** define max scaled bin value
+		auto itEnd = prev(end());	// pointed to the LAST item!
+		size_t undefCnt = 0;		// count of regions with undefined CC
+		while (itEnd->second > 1)	// eliminate UNDEF CC
+			itEnd--, undefCnt++;
+		float maxBin = float(F * itEnd->second);
+		{	// round maxBin
+			int	maxdecBin = int(maxBin);
+			if (maxBin - maxdecBin)	maxdecBin++;	// round up
+			if (maxdecBin % 2)		maxdecBin++;	// get even bin
+			maxBin = float(maxdecBin) / F;
 		}
+		vector<int> hist(size_t((maxBin - minBin) / binWidth) + 1, 0);		// histogram
+
+		// ** fill histogram by consolidated values
+		while (it <= itEnd)
+			hist[int((maxBin - it++->second) / binWidth)]++;
+
+		// ** cut off low bins with zero value
+		size_t lim = hist.size() - 1;
+		for (size_t k = lim; k; k--)
+			if (!hist[k]) lim--;
+			else break;
+		// ** print histogram
+		dout << "BIN UP\tCOUNT\n";
+		for (BYTE k = 0; k <= lim; k++)
+			dout << (maxBin - k * binWidth) << TAB << hist[k] << LF;
+		if (undefCnt)
+			dout << sUNDEF << TAB << undefCnt << LF;
+	}
 
-		// Returnes Pearson CC
-		float PCC() {
-			return GetR(_len * _sumXY - _sumX * _sumY,
-				_len * _sumSqrX - _sumX * _sumX,
-				_len * _sumSqrY - _sumY * _sumY);
-		}
-	};
+public:
+	using vector<FeatureR>::size;
+	using vector<FeatureR>::operator[];
+
+	inline void Reserve(chrlen cnt) { reserve(cnt); }
 
-	// 'FeatureR' represetns pair <feature-ID><feature-PCC>
-	struct FeatureR : pair<chrlen, float>
+	inline void AddVal(chrlen ind, float val) { emplace_back(ind + 1, val); }
+
+	// Adds results of the following features
+	void Append(const FeatureRs& rs) { insert(end(), rs.begin(), rs.end()); }
+
+	// Removes the results following the given number of the first ones
+	void Truncate(size_t cnt) { erase(begin() + cnt, end()); }
+
+	// Prints result and histogram
+	void Print(eRS printFRes, float binWidth)
 	{
-		inline FeatureR(chrlen id, float cc) { first = id; second = cc; }
+		if (printFRes != rsOFF) {
+			if (printFRes == rsC)		// soretd by feature; are sorted initially
+				sort(begin(), end());	// by increase
+			dout << "\n#RGN\tCC\n";
+			for (const auto& cc : *this)		cc.Print();
+		}
+		if (binWidth)	PrintHist(binWidth);
+	}
+};
+
+// 'FeatureSpan' represents the range of chrom's template features treated at once
+struct FeatureSpan
+{
+	Items<Featr>::cItemsIter First, Last;	// first and after the last feature
+	chrlen	FirstInd;						// index of the first feature in the chrom
+
+	// Creates span of all the chrom's features
+	FeatureSpan(const Features& templ, chrid cID) {
+		auto itC = templ.GetIter(cID);
+		First = templ.ItemsBegin(itC);
+		Last = templ.ItemsEnd(itC);
+		FirstInd = 0;
+	}
 
-		inline bool operator < (const FeatureR& rccr) const { return second < rccr.second; }
+	// Creates span of the chrom's features
+	//	@first: index of the first feature in the chrom
+	//	@last: index of the feature after the last one in the chrom
+	FeatureSpan(const Features& templ, chrid cID, chrlen first, chrlen last) : FeatureSpan(templ, cID) {
+		Last = First + last;
+		First += first;
+		FirstInd = first;
+	}
+};
 
-		void Print() const { dout << first << TAB; PrintR(second); }
-	};
+// 'ChromMerge' accumulates sums of two covers within the chrom, using single-pass range-based algorithm.
+// The kernel is specialized by the template usage, so the checks that are constant for the run
+// are eliminated from the loop; this is 10-15% faster than checking them at run time.
+// Outside the template features the cursors jump straight to the next feature,
+// so a sparse template costs O(features * log(intervals)) instead of O(intervals).
+// The merge can be suspended at any position and resumed with the same results,
+// so the merges with several compared covers can pass the first cover block by block.
+//	@withTempl: true if template is defined
+//	@withLoc: true if coefficients of the template features should be filled; requires withTempl
+template<bool withTempl, bool withLoc, typename CX, typename CY>
+class ChromMerge
+{
+	CX	_itX;					// first cover's chrom cursor
+	CY	_itY;					// second cover's chrom cursor
+	Items<Featr>::cItemsIter _itF, _itFend;	// template feature iterator
+	chrlen	_ind = 0;			// feature index
+	chrlen	_pos = 0;			// current position
+	float	_valX = 0, _valY = 0;	// first sequence, second sequence current value
+	bool	_inTempl;			// true if current position did not go beyond the border of the last feature
+	spR		_locR;				// sums of the current feature
+	spR&	_chrR;				// chrom sums accumulator
+	FeatureRs* _locResults;		// coefficients of the template features
 
-	// 'FeatureRs' represetns FeatureR collection, including methods to print collection and CC histogram
-	class FeatureRs : vector<FeatureR>
+public:
+	// Creates the merge
+	//	@itX: first cover's chrom cursor
+	//	@itY: second cover's chrom cursor
+	//	@fSpan: treated template features; ignored if withTempl is false
+	//	@chrR: chrom sums accumulator
+	//	@locResults: coefficients of the template features, or NULL if they should not be filled
+	ChromMerge(CX itX, CY itY, const FeatureSpan* fSpan, spR& chrR, FeatureRs* locResults)
+		: _itX(move(itX)), _itY(move(itY)), _chrR(chrR), _locResults(locResults)
 	{
-		// Creates and prints histogram
-		void PrintHist(float binWidth)
-		{
-			// ** set abs values and sort
-			for (auto& i : *this)
-				if (i.second < 0)	i.second = -i.second;
-			sort(begin(), end());	// by increase
-			
-			// ** define factor - a divisor of binWidth: 0.1--0.9=>10, 0.01--0.09=>100 etc
-			short F = 10;
-			for (; binWidth * F < 1; F *= 10);
-
-			// ** define min scaled bin value
-			auto it = begin();
-			// then float instead of double because of wrong consolidation by round double
-			float minBin = float(int(it->second * F)) / F;
-			
-			// ** define max scaled bin value
-			auto itEnd = prev(end());	// pointed to the LAST item!
-			size_t undefCnt = 0;		// count of regions with undefined CC
-			while (itEnd->second > 1)	// eliminate UNDEF CC
-				itEnd--, undefCnt++;
-			float maxBin = float(F * itEnd->second);
-			{	// round maxBin
-				int	maxdecBin = int(maxBin);
-				if (maxBin - maxdecBin)	maxdecBin++;	// round up
-				if (maxdecBin % 2)		maxdecBin++;	// get even bin
-				maxBin = float(maxdecBin) / F;
-			}
-			vector<int> hist(size_t((maxBin - minBin) / binWidth) + 1, 0);		// histogram
-
-			// ** fill histogram by consolidated values
-			while (it <= itEnd)
-				hist[int((maxBin - it++->second) / binWidth)]++;
-
-			// ** cut off low bins with zero value
-			size_t lim = hist.size() - 1;
-			for (size_t k = lim; k; k--)
-				if (!hist[k]) lim--;
-				else break;
-			// ** print histogram
-			dout << "BIN UP\tCOUNT\n";
-			for (BYTE k = 0; k <= lim; k++)
-				dout << (maxBin - k * binWidth) << TAB << hist[k] << LF;
-			if (undefCnt)
-				dout << sUNDEF << TAB << undefCnt << LF;
-		}
-
-	public:
-		inline FeatureRs(chrlen cnt) { reserve(cnt); }
-
-		inline void AddVal(chrlen ind, float val) { emplace_back(ind + 1, val); }
-
-		// Prints result and histogram
-		void Print(eRS printFRes, float binWidth)
-		{
-			if (printFRes != rsOFF) {
-				if (printFRes == rsC)		// soretd by feature; are sorted initially
-					sort(begin(), end());	// by increase
-				dout << "\n#RGN\tCC\n";
-				for (const auto& cc : *this)		cc.Print();
-			}
-			if (binWidth)	PrintHist(binWidth);
+		if (withTempl) {
+			_itF = fSpan->First;
+			_itFend = fSpan->Last;
+			_ind = fSpan->FirstInd;
+			if (withLoc)	locResults->Reserve(chrlen(_itFend - _itF));
 		}
-	};
+		_inTempl = withTempl && _itF != _itFend;
+	}
 
-	const bool fillLocRes = templ && (_binWidth || _printFRes);
-	spR chrR, totR;
-#ifdef _DEBUG
-	//Print("first", 0);
-	//cv.Print("second", 0);	cout << LF;
-	////rgns.Print();
-	//if (templ)	templ->Print();
-#endif
-	// rgns is already limited by chroms represented in template, if it's defined
-	for (auto rit = rgns.cBegin(); rit != rgns.cEnd(); rit++) {
-		cIter itC_this = GetIter(CID(rit));
-		if (itC_this == cEnd())		continue;	// chrom not found
-		cIter itC_cv = cv.GetIter(CID(rit));
-		if (itC_cv == cv.cEnd())	continue;	// chrom not found
+	// Accumulates sums up to the given position
+	//	@lim: position before which the merge is suspended
+	//	return: true if the merge is not finished
+	bool Run(chrlen lim = CHRLEN_UNDEF)
+	{
+		CX& itX = _itX;
+		CY& itY = _itY;
+		auto itF = _itF;
+		chrlen posN, pos = _pos;		// max(posX,posY), current position
+		float valX = _valX, valY = _valY;
+		bool inTempl = _inTempl;
 
-		chrlen fCnt = 0;						// count of templ features
-		Items<Featr>::cItemsIter itF, itFend;	// template feature iterator
-		if (templ) {
-			auto itC = templ->GetIter(CID(rit));
-			itF = templ->ItemsBegin(itC);
-			itFend = templ->ItemsEnd(itC);
-			fCnt = chrlen(templ->ItemsCount(itC));
-		}
-
-		// local results
-		chrlen ind = 0;				// item index
-		chrlen len;					// length of current united (with equal X, Y values) region
-		chrlen posN, pos = 0;		// max(posX,posY), current position, 
-		float valX = 0, valY = 0;	// first sequence, second sequence current value
-		bool insideF = !templ;		// true if current position is inside current template feature
-		bool inTempl = templ;		// true if current position did not go beyond the border of the last feature 
-		bool closeF = false;		// true if the feature has just ended
-		spR locR;
-		FeatureRs locResults(_binWidth ? fCnt : 0);	// create histogram
-		const auto itXend = ItemsEnd(itC_this), itYend = cv.ItemsEnd(itC_cv);
-
-		chrR.Clear();
 		// loop through cover items (intervals)
-		for (auto itX = ItemsBegin(itC_this), itY = cv.ItemsBegin(itC_cv); itX != itXend && itY != itYend; ) {
+		while (!itX.IsEnd() && !itY.IsEnd() && pos < lim) {
+			if (withTempl) {
+				if (!inTempl)	break;		// there is nothing to accumulate beyond the last feature
+				if (pos < itF->Start) {		// skip the items before the feature
+					itX.SeekTo(itF->Start, valX);
+					itY.SeekTo(itF->Start, valY);
+					if (itX.IsEnd() || itY.IsEnd())	break;
+				}
+			}
 			const chrlen posX = itX->Pos, posY = itY->Pos;
 			const float prevValX = valX, prevValY = valY;	// X, Y current value
 
 			//== set valX, valY
 			if (posX > posY)			// more
-				posN = posY, valY = itY++->Val;
+				posN = posY, valY = itY->Val, ++itY;
 			else {						// equal or less
-				posN = posX; valX = itX++->Val;
+				posN = posX; valX = itX->Val; ++itX;
 				if (posX == posY) 		// equal
-					valY = itY++->Val;
-			}
-			//== set pos, len
-			if (inTempl)
-				if (posN > itF->End) {						// exit current feature
-					closeF = true;
-					len = SetPos(pos, itF->End);			// take len including the end of the feature
-					inTempl = ++itF != itFend;				// next feature
-				}
-				else if (!insideF && posN >= itF->Start)	// entry current feature
-					insideF = true,
-					len = (pos = posN) - itF->Start;		// cutoff range before feature start
-				else 
-					len = SetPos(pos, posN);
-			else 
-				len = SetPos(pos, posN);
-
-			//== accumulate sums; the last interval, ended by pos, is saved!!
-			if (insideF && len) {		// len can be 0 at the boundary of the feature
-				if (fillLocRes)		
-					locR.AddVal(len, prevValX, prevValY);
-				chrR.AddVal(len, prevValX, prevValY);		// previous combined region
-				if (PrintMngr::IsPrintTotal())
-					totR.AddVal(len, prevValX, prevValY);
+					valY = itY->Val, ++itY;
 			}
 
-			//== close feature, save loc CC
-			if (closeF) {
-				if (fillLocRes) {			// add CC for each feature
-					locResults.AddVal(ind++, locR.PCC());
-					locR.Clear();
+			//== accumulate sums of the previous combined region [pos, posN)
+			if (withTempl) {
+				// the region is cut off by the features, and it can overlap several of them
+				while (inTempl && itF->Start < posN) {
+					const chrlen start = max(pos, itF->Start), end = min(posN, itF->End);
+					if (end > start) {
+						if (withLoc)
+							_locR.AddVal(end - start, prevValX, prevValY);
+						_chrR.AddVal(end - start, prevValX, prevValY);
+					}
+					if (posN <= itF->End)	break;	// the feature continues
+					//== close feature, save loc CC
+					if (withLoc) {
+						_locResults->AddVal(_ind++, _locR.PCC());
+						_locR.Clear();
+					}
+					inTempl = ++itF != _itFend;		// next feature
 				}
-				closeF = insideF = false;
 			}
+			else if (posN > pos)
+				_chrR.AddVal(posN - pos, prevValX, prevValY);
+			pos = posN;
 		}
-		
-		//== print current result
-		if (PrintMngr::IsPrintLocal()) {
-			if (templ)
-				locResults.Print(_printFRes, _binWidth);
-			PrintMngr::PrintCC(chrR.PCC(), CID(rit));
-		}
+		_itF = itF;
+		_pos = pos;
+		_valX = valX, _valY = valY;
+		_inTempl = inTempl;
+		return !itX.IsEnd() && !itY.IsEnd() && (!withTempl || inTempl);
 	}
-	if (PrintMngr::IsPrintTotal())
-		PrintMngr::PrintCC(totR.PCC());
-	return chrR.IsDone() || totR.IsDone();
+};
+
+// Accumulates sums of two covers within the chrom, calling the kernel specialized by the template usage
+//	@itX: first cover's chrom cursor
+//	@itY: second cover's chrom cursor
+//	@fSpan: treated template features, or NULL if template is not defined
+//	@chrR: chrom sums accumulator
+//	@locResults: coefficients of the template features, or NULL if they should not be filled
+template<typename CX, typename CY>
+void CalcChromR(CX itX, CY itY, const FeatureSpan* fSpan, spR& chrR, FeatureRs* locResults)
+{
+	if (!fSpan)
+		ChromMerge<false, false, CX, CY>(itX, itY, fSpan, chrR, nullptr).Run();
+	else if (locResults)
+		ChromMerge<true, true, CX, CY>(itX, itY, fSpan, chrR, locResults).Run();
+	else
+		ChromMerge<true, false, CX, CY>(itX, itY, fSpan, chrR, nullptr).Run();
 }
 
-// Writes inner representation to BEDGRAPG file
-void PlainCover::Write(const string& fName) const
+// Accumulates sums of two covers within the chrom, regardless of their layouts
+//	@cv1: first cover
+//	@cv2: second cover
+//	@cID: chrom presented in both covers
+//	@fSpan: treated template features, or NULL if template is not defined
+//	@chrR: chrom sums accumulator
+//	@locResults: coefficients of the template features, or NULL if they should not be filled
+void CalcChromR(const PlainCover& cv1, const PlainCover& cv2, chrid cID,
+	const FeatureSpan* fSpan, spR& chrR, FeatureRs* locResults)
 {
-	ofstream file;
-	file.open(fName);
-	file << "track type=bedGraph\n";
-	for (const auto& c : Container()) {
-		const string& chr = Chrom::AbbrName(c.first);
-		const auto itEnd = --ItemsEnd(c.second.Data);
-		for (auto it = ItemsBegin(c.second.Data); it != itEnd; it++)
-			if(it->Val)
-				file << chr << TAB << it->Pos << TAB << next(it)->Pos << TAB << it->Val << LF;
+	typedef PlainCover::PlainCursor		Plain;
+	typedef PlainCover::PackedCursor	Packed;
+
+	if (cv1.IsPacked())
+		if (cv2.IsPacked())
+			CalcChromR(Packed(cv1, cID), Packed(cv2, cID), fSpan, chrR, locResults);
+		else
+			CalcChromR(Packed(cv1, cID), Plain(cv2, cID), fSpan, chrR, locResults);
+	else
+		if (cv2.IsPacked())
+			CalcChromR(Plain(cv1, cID), Packed(cv2, cID), fSpan, chrR, locResults);
+		else
+			CalcChromR(Plain(cv1, cID), Plain(cv2, cID), fSpan, chrR, locResults);
+}
+
+// Accumulates sums of two covers within the chrom, regardless of their layouts
+//	@templ: template to define treated regions, or NULL
+void CalcChromR(const PlainCover& cv1, const PlainCover& cv2, chrid cID,
+	const Features* templ, spR& chrR, FeatureRs* locResults)
+{
+	if (templ) {
+		const FeatureSpan fSpan(*templ, cID);
+		CalcChromR(cv1, cv2, cID, &fSpan, chrR, locResults);
 	}
-	file.close();
+	else
+		CalcChromR(cv1, cv2, cID, (const FeatureSpan*)nullptr, chrR, locResults);
 }
 
-/************************ end of PlainCover ************************/
+// Accumulates sums of the cover and the chrom's items of another cover, regardless of the cover layout
+//	@cv: first cover
+//	@first: pointer to the first item of the second cover's chrom
+//	@last: pointer after the last item of the second cover's chrom
+//	@cID: chrom presented in both covers
+//	@templ: template to define treated regions, or NULL
+//	@chrR: chrom sums accumulator
+//	@locResults: coefficients of the template features, or NULL if they should not be filled
+void CalcChromR(const PlainCover& cv, const ValPos* first, const ValPos* last, chrid cID,
+	const Features* templ, spR& chrR, FeatureRs* locResults)
+{
+	const PlainCover::PlainCursor itY(first, last);
+	unique_ptr<FeatureSpan> fSpan(templ ? new FeatureSpan(*templ, cID) : nullptr);
 
-/************************ class Cover ************************/
+	if (cv.IsPacked())
+		CalcChromR(PlainCover::PackedCursor(cv, cID), itY, fSpan.get(), chrR, locResults);
+	else
+		CalcChromR(PlainCover::PlainCursor(cv, cID), itY, fSpan.get(), chrR, locResults);
+}
 
-// Initializes instance from wig file
-//	return: numbers of all and initialied items for given chrom
-void Cover::InitWiggle(BedReader& file, const ChromSizes& cSizes)
+// Splits chrom's template features into spans which can be treated independently.
+// Each feature accumulates the regions that it cuts off the covers, so its result does not depend
+// on the previous features. Spans have a fixed length, so the results do not depend on the number of threads.
+//	@templ: template
+//	@cID: chrom presented in template
+//	@spans: filled spans
+void SplitFeatures(const Features& templ, chrid cID, vector<FeatureSpan>& spans)
 {
-	static const string keyChrom = "chrom";
-	static const string keyStart = "start";
-	static const string keyStep = "step";
-	static const string keySpan = "span";
+	const chrlen spanLen = 1 << 12;		// number of features in the span
+	const chrlen fCnt = chrlen(templ.ItemsCount(templ.GetIter(cID)));
 
-	bool	skipChrom = false;		// if true skip data lines for current chrom
-	chrlen	prevEnd = 0,			// previous region end position, 
-			span = 1, step = 0;		// span spec, step spec (for fixedStep),
-	const char* line;
-	const bool fixedStep = file.Type() == FT::eType::WIG_FIX;
-	chrid	cID = Chrom::UnID, nextCID = cID;	// current, next chrom ID
-	ULONG	cItemCnt = 0,	// count of total accepted intervals
-			itemCnt = 0,	// count of accepted intervals of current chrom, total
-			recCnt = 0;		// count of total records
-	BYTE	offset = 0;		// offset to value delimiter (TAB or SPACE); for Variable Step, only increases
-	ValPos	vPos;			// region start position & value
-	char	firstC;
-	Timer timer(UniBedReader::IsTimer);
-	// pointer to initialise position & value function
-	void (*setValPos)(ValPos & vPos, chrlen step, BYTE & offset, const char* s);
-
-	if(fixedStep) {
-		firstC = 'f';
-		setValPos = [](ValPos& vPos, chrlen step, BYTE&, const char* s) {
-			vPos.Pos += step;
-			vPos.Val = float(atof(s));
-		};
-	}
-	else {
-		firstC = 'v';
-		setValPos = [](ValPos& vPos, chrlen, BYTE& offset, const char* s) {
-			vPos.Pos = atoi(s);
-			for (s += offset; *s != SPACE && *s != TAB; ++s, ++offset);	// go to value
-			vPos.Val = float(atof(++s));
-		};
-	}
+	for (chrlen first = 0; first < fCnt; first += spanLen)
+		spans.emplace_back(templ, cID, first, min(first + spanLen, fCnt));
+}
 
-	while (line = file.GetNextLine(false))
-		if (*line == firstC) {		// *** declaration line
-			// *** set specifications
-			// ** check keyChrom
-			line = file.ChromMark() - strlen(Chrom::Abbr);					// level the initial value of chrom mark position
-			const char* line1 = line = file.CheckSpec(line, keyChrom) + 1;	// keyChrom initial position
+// 'BinSums' keeps sums of two signals given by dense bins
+struct BinSums
+{
+	double X = 0, Y = 0, SqrX = 0, SqrY = 0, XY = 0;
+};
 
-			if (fixedStep) {							// fix declarative parameters
-				// * check keyStart & keyStep
-				vPos.Pos = file.GetIntKey(line1, keyStart);	// initial position
-				line1 += keyStart.length() + 1;			// shift to scan the rest of the line faster
-				step = file.GetIntKey(line1, keyStep);	// initial step
-				vPos.Pos -= step;						// shift 'back' before the first pass, where pos+=step will be invoke
-				line1 += keyStep.length() + 1;			// shift to scan the rest of the line faster
-			}
-			line1 = TabReader::KeyStr(line1, keySpan);
-			span = line1 ? atoi(line1 + 1) : 1;		// initial span: both for fixed- and variableStep
-			// * check chrom
-			if (file.GetNextChrom(nextCID, line)) {
-				if (Chrom::IsSetByUser()) {			// is single chrom specified?
-					if (!fixedStep && vPos.Pos)		// region is initialized: items for the specified chrom are existed and saved
-						break;						// the chrom itself will be saved after loop
-					if (skipChrom = nextCID != Chrom::UserCID())
-						continue;
-				}
-				else {								// all chroms are specified
-					if (cID != Chrom::UnID)			// skip first pass, when curr chrom is still undefined
-						PlainCover::AddChrom(cID, cSizes[cID], prevEnd),
-						itemCnt += cItemCnt;
-				}
-				cID = nextCID;
-				cItemCnt = prevEnd = offset = 0;
-				vPos.Clear();
-			}
-		}
-		else {				// *** data line
-			if (skipChrom)	continue;
-			setValPos(vPos, step, offset, file.GetLine());
-			cItemCnt += AddPos(vPos, prevEnd);
-			prevEnd = vPos.Pos + span;
-			recCnt++;
+// Accumulates sums of two signals given by dense bins in independent lanes, using the compiler's vectorizer
+//	@x: first signal bins
+//	@y: second signal bins
+//	@cnt: number of bins
+//	@s: sums accumulator
+//	return: number of the treated bins; the rest is less than the number of lanes
+size_t AddBinLanes(const float* x, const float* y, size_t cnt, BinSums& s)
+{
+	const size_t lanes = 4;
+	double sX[lanes]{}, sY[lanes]{}, sXX[lanes]{}, sYY[lanes]{}, sXY[lanes]{};
+	size_t i = 0;
+
+	for (; i + lanes <= cnt; i += lanes)
+		for (size_t j = 0; j < lanes; j++) {
+			const double vx = x[i + j], vy = y[i + j];
+			sX[j] += vx;
+			sY[j] += vy;
+			sXX[j] += vx * vx;
+			sYY[j] += vy * vy;
+			sXY[j] += vx * vy;
 		}
-	// save last chrom
-	if (cID != Chrom::UnID) {	// is last chrom valid?
-		PlainCover::AddChrom(cID, cSizes[cID], prevEnd);
-		itemCnt += cItemCnt;
-	}
-	// print stats
-	if (PrintMngr::OutInfo() >= eOInfo::STD) {
-		if (itemCnt == 1)	itemCnt = 0;	// single interval is equal to an empty coverage
-		UniBedReader::PrintItemCount(itemCnt, FT::ItemTitle(FT::eType::WIG_FIX, itemCnt != 1));
-		if (PrintMngr::OutInfo() == eOInfo::STAT)
-			dout << " (" << recCnt << " data lines)";
-		if (!(Timer::Enabled && UniBedReader::IsTimer))	dout << LF;
+	for (size_t j = 0; j < lanes; j++) {
+		s.X += sX[j];
+		s.Y += sY[j];
+		s.SqrX += sXX[j];
+		s.SqrY += sYY[j];
+		s.XY += sXY[j];
 	}
-	timer.Stop(1, true);	if (PrintMngr::OutInfo() > eOInfo::NM)	dout << LF;
+	return i;
 }
 
-Cover::Cover(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval)
-	: PlainCover()
+#ifdef _SIMD_DISPATCH
+// Returns the sum of the AVX2 lanes
+SIMD_TARGET("avx2")
+inline double ReduceAVX2(__m256d v)
 {
-	UniBedReader file(fName, FT::eType::BGRAPH, &cSizes, 4, 0, oinfo, true, abortInval);
+	const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+	return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
 
-	ReserveItems(file.EstItemCount());	// EstItemCount() > 0 even for empty file, because of track line
-	if (file.Type() == FT::eType::BGRAPH)
-		Pass(this, file);
-	else
-		InitWiggle((BedReader&)file.BaseFile(), cSizes);
-	
-	if (Options::GetBVal(oWRITE)) {
-		const string ext = FS::GetExt(fName);
-		Write(FS::FileNameWithoutExt(fName) + "_out." + ext);
+// Accumulates sums of two signals given by dense bins in independent lanes, using AVX2 instructions
+//	@x: first signal bins
+//	@y: second signal bins
+//	@cnt: number of bins
+//	@s: sums accumulator
+//	return: number of the treated bins; the rest is less than 4
+SIMD_TARGET("avx2")
+size_t AddBinLanesAVX2(const float* x, const float* y, size_t cnt, BinSums& s)
+{
+	__m256d sX = _mm256_setzero_pd(), sY = sX, sXX = sX, sYY = sX, sXY = sX;
+	size_t i = 0;
+
+	for (; i + 4 <= cnt; i += 4) {
+		const __m256d vx = _mm256_cvtps_pd(_mm_loadu_ps(x + i));
+		const __m256d vy = _mm256_cvtps_pd(_mm_loadu_ps(y + i));
+		sX = _mm256_add_pd(sX, vx);
+		sY = _mm256_add_pd(sY, vy);
+		sXX = _mm256_add_pd(sXX, _mm256_mul_pd(vx, vx));
+		sYY = _mm256_add_pd(sYY, _mm256_mul_pd(vy, vy));
+		sXY = _mm256_add_pd(sXY, _mm256_mul_pd(vx, vy));
 	}
-
-	//PrintEst(file.EstItemCount());
+	s.X += ReduceAVX2(sX);
+	s.Y += ReduceAVX2(sY);
+	s.SqrX += ReduceAVX2(sXX);
+	s.SqrY += ReduceAVX2(sYY);
+	s.XY += ReduceAVX2(sXY);
+	return i;
 }
 
-/************************ end of class Cover ************************/
-
-/************************ class ReadDens ************************/
+// Accumulates sums of two signals given by dense bins in independent lanes, using AVX-512 instructions
+//	@x: first signal bins
+//	@y: second signal bins
+//	@cnt: number of bins
+//	@s: sums accumulator
+//	return: number of the treated bins; the rest is less than 8
+SIMD_TARGET("avx512f")
+size_t AddBinLanesAVX512(const float* x, const float* y, size_t cnt, BinSums& s)
+{
+	__m512d sX = _mm512_setzero_pd(), sY = sX, sXX = sX, sYY = sX, sXY = sX;
+	size_t i = 0;
+
+	for (; i + 8 <= cnt; i += 8) {
+		const __m512d vx = _mm512_cvtps_pd(_mm256_loadu_ps(x + i));
+		const __m512d vy = _mm512_cvtps_pd(_mm256_loadu_ps(y + i));
+		sX = _mm512_add_pd(sX, vx);
+		sY = _mm512_add_pd(sY, vy);
+		sXX = _mm512_fmadd_pd(vx, vx, sXX);
+		sYY = _mm512_fmadd_pd(vy, vy, sYY);
+		sXY = _mm512_fmadd_pd(vx, vy, sXY);
+	}
+	s.X += _mm512_reduce_add_pd(sX);
+	s.Y += _mm512_reduce_add_pd(sY);
+	s.SqrX += _mm512_reduce_add_pd(sXX);
+	s.SqrY += _mm512_reduce_add_pd(sYY);
+	s.XY += _mm512_reduce_add_pd(sXY);
+	return i;
+}
 
-// Adds chrom to the instance
-//	@cID: current chrom ID
-//	@cLen: current chrom length
-void ReadDens::AddChrom(chrid cID, chrlen cLen)
+// Returns the widest instruction set supported by both the processor and the OS:
+// 2 for AVX-512, 1 for AVX2, 0 for none of them
+BYTE SimdLevel()
 {
-	// fill items
-	chrlen prevEnd = 0;
-	for (const freqPair& i : *_freq) {
-		AddPos(i, prevEnd);
-		prevEnd = i.first + 1;
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7)	return 0;
+	__cpuid(info, 1);
+	if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)))	return 0;	// no OSXSAVE or AVX
+	const unsigned long long xcr0 = _xgetbv(0);
+	if ((xcr0 & 0x6) != 0x6)	return 0;		// XMM and YMM states are not saved by the OS
+	__cpuidex(info, 7, 0);
+	if ((info[1] & (1 << 16)) && (xcr0 & 0xE0) == 0xE0)	return 2;	// AVX512F with opmask and ZMM states
+	return (info[1] & (1 << 5)) ? 1 : 0;		// AVX2
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))	return 2;
+	return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+}
+#endif	// _SIMD_DISPATCH
+
+// Accumulates sums of two signals given by dense bins.
+// The sums are accumulated in double precision in independent lanes, which are processed
+// by AVX-512 or AVX2 instructions if the processor supports them, or by the compiler's vectorizer otherwise.
+// The instruction set is checked once at run time, so the same binary runs on any x86 processor.
+//	@x: first signal bins
+//	@y: second signal bins
+//	@cnt: number of bins
+//	@chrR: sums accumulator
+void AddBinSums(const float* x, const float* y, size_t cnt, spR& chrR)
+{
+	BinSums s;
+#ifdef _SIMD_DISPATCH
+	static const BYTE simdLevel = SimdLevel();
+	size_t i =
+		simdLevel == 2 ? AddBinLanesAVX512(x, y, cnt, s) :
+		simdLevel == 1 ? AddBinLanesAVX2(x, y, cnt, s) :
+		AddBinLanes(x, y, cnt, s);
+#else
+	size_t i = AddBinLanes(x, y, cnt, s);
+#endif
+
+	for (; i < cnt; i++) {		// the rest
+		const double vx = x[i], vy = y[i];
+		s.X += vx;
+		s.Y += vy;
+		s.SqrX += vx * vx;
+		s.SqrY += vy * vy;
+		s.XY += vx * vy;
 	}
-	_freq->clear();
-	PlainCover::AddChrom(cID, cLen, prevEnd);
+	chrR.AddSums(cnt, s.X, s.SqrX, s.Y, s.SqrY, s.XY);
 }
 
-ReadDens::ReadDens(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval)
-	: PlainCover()
+// Accumulates sums of two covers in dense layout within the chrom
+//	@bins1: first cover bins
+//	@bins2: second cover bins
+//	@cID: chrom presented in both covers
+//	@chrR: chrom sums accumulator
+void CalcChromR(const PlainCover::BinnedItems& bins1, const PlainCover::BinnedItems& bins2, chrid cID, spR& chrR)
 {
-	RBedReader file(fName, &cSizes, BYTE(Options::GetRDuplPermit(oDUPL)), oinfo, abortInval);
-	rfreq freq;
-	_freq = &freq;
+	const vector<float>& x = bins1.Bins(cID);
+	const vector<float>& y = bins2.Bins(cID);
 
-	ReserveItems(file.EstItemCount());
-	Pass(this, file);
-	_freq = nullptr;
+	AddBinSums(x.data(), y.data(), min(x.size(), y.size()), chrR);
+}
 
-	//PrintEst(file.EstItemCount());
+// Accumulates approximate sums of two covers within the chrom by their pyramids.
+// The sum of products within each window is replaced by the product of the window sums divided by its length,
+// which is exact if either cover is constant within the window; the other sums are exact.
+// By Cauchy-Schwarz inequality, the error within the window does not exceed the geometric mean
+// of the sums of squared deviations of both covers from their window means.
+// If the pyramids have different lengths, the last window of the shorter one is incomplete
+// while the same window of the longer one is not, so only the complete windows common to both are treated.
+//	@pyr1: first cover pyramid
+//	@pyr2: second cover pyramid
+//	@cID: chrom presented in both covers
+//	@level: level of the pyramids
+//	@chrR: chrom sums accumulator
+//	return: bound of the error of the sum of products
+double CalcChromR(const PlainCover::Pyramid& pyr1, const PlainCover::Pyramid& pyr2, chrid cID, BYTE level, spR& chrR)
+{
+	const PlainCover::Pyramid::WinSums* wX = pyr1.Windows(cID, level);
+	const PlainCover::Pyramid::WinSums* wY = pyr2.Windows(cID, level);
+	const chrlen len1 = pyr1.Length(cID), len2 = pyr2.Length(cID);
+	const chrlen winLen = PlainCover::Pyramid::WinLens[level];
+	const chrlen len = len1 == len2 ? len1 : min(len1, len2) / winLen * winLen;	// treated length
+	const size_t cnt = PlainCover::Pyramid::WinCount(len, level);
+	double sumX = 0, sumY = 0, sumSqrX = 0, sumSqrY = 0, sumXY = 0, err = 0;
+
+	for (size_t i = 0; i < cnt; i++) {
+		const double wLen = i + 1 < cnt ? winLen : len - i * winLen;	// the last window can be shorter
+		const double sX = wX[i].Sum, sY = wY[i].Sum;
+
+		sumX += sX;		sumSqrX += wX[i].SumSqr;
+		sumY += sY;		sumSqrY += wY[i].SumSqr;
+		sumXY += sX * sY / wLen;
+		err += sqrt(max(0.0, wX[i].SumSqr - sX * sX / wLen) * max(0.0, wY[i].SumSqr - sY * sY / wLen));
+	}
+	chrR.AddSums(len, sumX, sumSqrX, sumY, sumSqrY, sumXY);
+	return err;
 }
 
-/************************ end of class ReadDens ************************/
+// 'PrefixSums' keeps the sums of two covers accumulated from the chrom start up to some position
+struct PrefixSums
+{
+	double	X = 0, Y = 0;		// sums of the values
+	double	SqrX = 0, SqrY = 0;	// sums of the squared values
+	double	XY = 0;				// sum of the products of the values
+
+	// Adds range of constant values
+	void Add(chrlen len, float valX, float valY) {
+		const double valXLen = double(valX) * len;
+		const double valYLen = double(valY) * len;
+
+		X += valXLen;	SqrX += valX * valXLen;
+		Y += valYLen;	SqrY += valY * valYLen;
+		XY += valXLen * valY;
+	}
+
+	// Returns sums between two positions
+	PrefixSums operator-(const PrefixSums& s) const {
+		PrefixSums res;
+		res.X = X - s.X;	res.SqrX = SqrX - s.SqrX;
+		res.Y = Y - s.Y;	res.SqrY = SqrY - s.SqrY;
+		res.XY = XY - s.XY;
+		return res;
+	}
+};
 
-JointedBeds::JointedBeds(const Features& fs1, const Features& fs2)
+// Relative tolerance of the window moments taken as the difference of the prefix sums.
+// The prefix sums grow along the chrom, so the moment of a window with constant signal is not exactly zero,
+// but stays within a few thousand double epsilons (2.2e-16) of the magnitude of the terms it is calculated from.
+static const double WinMomentTol = 1e-12;
+
+// Calculates coefficients of two covers within the chrom in sliding windows.
+// The sums in each window are the difference of the prefix sums at its ends, which are taken
+// from the running sums over the merged interval stream, so each window costs O(1) regardless of its length.
+//	@itX: first cover's chrom cursor
+//	@itY: second cover's chrom cursor
+//	@winLen: length of window
+//	@step: step of window
+//	@res: filled pairs <window start><coefficient>; windows with undefined coefficient are omitted
+template<typename CX, typename CY>
+void CalcChromWinR(CX itX, CY itY, chrlen winLen, chrlen step, vector<pair<chrlen, float>>& res)
 {
-	const Region fEnd = Region(CHRLEN_UNDEF, CHRLEN_UNDEF - 1);	// last chromosome's joint feature
-	const char VAL1 = 0x1;	// value represented first Features's feature
-	const char VAL2 = 0x2;	// value represented second Features's feature
-	const auto cit1end = fs1.cEnd(), cit2end = fs2.cEnd();
-
-	chrlen	firstInd = 0, lastInd = 0;	// current first, last feature indexes in JointedBeds
-
-	_ranges.reserve(2 * (fs1.Count() + fs2.Count()));	// ranges
-	for (auto cit1 = fs1.cBegin(); cit1 != cit1end; cit1++) {
-		auto cit2 = fs2.GetIter(CID(cit1));
-		if(cit2 == cit2end)			continue;		// no chrom
-		const chrlen fCnt1 = chrlen(fs1.ItemsCount(cit1));	// count of features in fs1, fs2
-		const chrlen fCnt2 = chrlen(fs2.ItemsCount(cit2));
-		Region r1 = fs1.Regn(cit1);
-		Region r2 = fs2.Regn(cit2);
-		char val = 0;							// current joint range value
-
-		// loop through current chromosome's features 
-		for (chrlen fi1 = 0, fi2 = 0; fi1 < fCnt1 || fi2 < fCnt2;) {
-			chrlen pos = val & VAL1 ? (r1.End + 1) : r1.Start;
-			const chrlen pos2 = val & VAL2 ? (r2.End + 1) : r2.Start;
-
-			if (pos < pos2) {
-				val ^= VAL1;		// flip val for fs1
-				if (!(val & VAL1))	// true when fs1 feature is closed (every second range)
-					r1 = ++fi1 < fCnt1 ? fs1.Feature(cit1, fi1) : fEnd;
-			}
-			else if (pos > pos2) {
-				pos = pos2;
-				val ^= VAL2;		// flip val for fs2
-				if (!(val & VAL2))	// true when fs2 feature is closed (every second range)
-					r2 = ++fi2 < fCnt2 ? fs2.Feature(cit2, fi2) : fEnd;
+	PrefixSums sums;		// prefix sums up to the current position
+	deque<PrefixSums> starts;	// prefix sums at the starts of the open windows
+	chrlen pos = 0, posN;		// current position, max(posX,posY)
+	chrlen nextStart = 0, nextEnd = winLen;	// start of the next window, end of the first open window
+	float valX = 0, valY = 0;
+
+	while (!itX.IsEnd() && !itY.IsEnd()) {
+		const chrlen posX = itX->Pos, posY = itY->Pos;
+		const float prevValX = valX, prevValY = valY;
+
+		if (posX > posY)
+			posN = posY, valY = itY->Val, ++itY;
+		else {
+			posN = posX; valX = itX->Val; ++itX;
+			if (posX == posY)
+				valY = itY->Val, ++itY;
+		}
+		// Returns prefix sums at the position within the current range
+		auto sumsAt = [&](chrlen p) { PrefixSums s = sums; s.Add(p - pos, prevValX, prevValY); return s; };
+
+		// window borders within the current range, in order
+		while (nextStart <= posN || nextEnd <= posN)
+			if (nextStart < nextEnd) {
+				starts.push_back(sumsAt(nextStart));
+				nextStart += step;
 			}
 			else {
-				val ^= VAL1 ^ VAL2;	// flip val for both beds
-				if (!(val & VAL1))	// true when fs1 feature is closed 
-					r1 = ++fi1 < fCnt1 ? fs1.Feature(cit1, fi1) : fEnd;
-				if (!(val & VAL2))	// true when fs2 feature is closed 
-					r2 = ++fi2 < fCnt2 ? fs2.Feature(cit2, fi2) : fEnd;
+				const PrefixSums end = sumsAt(nextEnd);
+				const PrefixSums s = end - starts.front();
+				// the zero moments are distorted by rounding of the prefix sums,
+				// so the moments within the tolerance of the magnitude of their terms are zeroed
+				auto moment = [](double m, double mag) { return fabs(m) > WinMomentTol * mag ? m : 0; };
+				const double varX = moment(winLen * s.SqrX - s.X * s.X,
+					winLen * end.SqrX + 2 * fabs(s.X * end.X));
+				const double varY = moment(winLen * s.SqrY - s.Y * s.Y,
+					winLen * end.SqrY + 2 * fabs(s.Y * end.Y));
+				const double cov = moment(winLen * s.XY - s.X * s.Y,
+					winLen * fabs(end.XY) + fabs(s.X * end.Y) + fabs(s.Y * end.X));
+
+				// the same rule as in 'R'; the window with undefined coefficient is omitted,
+				// since bedGraph has no undefined value, and the gap shows it in the browser
+				if (!cov)				res.emplace_back(nextEnd - winLen, 1.f);
+				else if (varX && varY)	res.emplace_back(nextEnd - winLen, float(cov / sqrt(varX) / sqrt(varY)));
+				starts.pop_front();
+				nextEnd += step;
 			}
-			_ranges.emplace_back(pos, val);	// add new joint feature
-			lastInd++;
-		}
-		AddVal(CID(cit1), ChromRanges(
-			firstInd, lastInd,
-			fs1.FeaturesLength(cit1),
-			fs2.FeaturesLength(cit2)
-		));
-		firstInd = lastInd;
+		sums.Add(posN - pos, prevValX, prevValY);
+		pos = posN;
 	}
 }
 
-bool JointedBeds::CalcR(const ChromSizes& cSizes)
+// 'ChromR' keeps the results of one chrom until they are printed
+struct ChromR
 {
-	// 'dsR' - discrete signal Pearson coefficient (R) calculater; keeps cumulative data & calculates PCC
-	class dsR : public R	// DsR
-	{
-		double	_var1 = 0, _var2 = 0;	// variances 
-		double	_cov = 0;				// covariance: SUM( X-Xmean)^2 * (Y-Ymean)^2 )
-		/*
-		Mean value for every range may accept only one of two values: 0-mean or 1-mean,
-		and they are const within chromosome.
-		So for efficiency we can keep theirs in 3 arrays:
-		two square's arrays: arrays of squared values from each bed;
-		there are only 2 combinations, but they are duplicated for the simplicity acces,
-		and one crossing array: array of all combinations
-		of multiplications different values from fs1 and fs2
-		*/
-		double _sqMeans1[4], _sqMeans2[4];	// square's arrays for fs1, fs2
-		double _crossMeans[4];				// crossing array
-
-	public:
-		// Keeps mean values for both features. 
-		//	@clear: if true, clear instance for treatment of new chromosome
-		void Init(const double(&mean)[2], bool clear) {
-			const double d1 = 1 - mean[0], d2 = 1 - mean[1];
-
-			_sqMeans1[0] = _sqMeans1[2] = mean[0] * mean[0];
-			_sqMeans1[1] = _sqMeans1[3] = d1 * d1;
-			_sqMeans2[0] = _sqMeans2[1] = mean[1] * mean[1];
-			_sqMeans2[2] = _sqMeans2[3] = d2 * d2;
-			_crossMeans[0] = mean[0] * mean[1];
-			_crossMeans[1] = -mean[1] * d1;
-			_crossMeans[2] = -mean[0] * d2;
-			_crossMeans[3] = d1 * d2;
-			if (clear)
-				_cov = _var1 = _var2 = 0;
-		}
-
-		// Accumulates next length of range
-		void Increment(chrlen len, char val) {
-			_cov += len * _crossMeans[val];
-			_var1 += len * _sqMeans1[val];
-			_var2 += len * _sqMeans2[val];
-		}
-
-		// Returns Pearson coefficient of correlation
-		inline float PCC() const { return GetR(_cov, _var1, _var2); }
-	};
-
-	const bool isPrLocal = PrintMngr::IsPrintLocal();
-	const bool isPrTotal = PrintMngr::IsPrintTotal();
-	const genlen gSize = isPrTotal ? cSizes.GenSize() : 0;	// genome's size
-	dsR chrR, totR;
-
-	for (const auto& c : Container()) {						// loop through chroms
-		const ChromRanges& cRanges = c.second.Data;			// current ChromRanges
-		const chrlen cSize = cSizes[c.first];
-		const double fsLen[2]{ 
-			double(cRanges.FeatrsLen1) / cSize,
-			double(cRanges.FeatrsLen2) / cSize
-		};
-		if (isPrLocal)	chrR.Init(fsLen, true);
-		if (isPrTotal)	totR.Init(fsLen, false);
-
-		chrlen start = 0, stop = 0, len;	// range's boundary positions, length of range
-		char val = 0;						// value of current range
-		for (auto ri = cRanges.FirstInd; ri <= cRanges.LastInd; ri++) {
-			stop = _ranges[ri].Start;
-			len = stop - start;
-			if (isPrLocal)	chrR.Increment(len, val);
-			if (isPrTotal)	totR.Increment(len, val);
-			// next range
-			val = _ranges[ri].Val;
-			start = stop;
-		}
-		len = cSize - stop;		// last range
+	spR			R;				// chrom coefficient
+	FeatureRs	LocResults;		// coefficients of the template features
+	double		ErrXY = 0;		// bound of the error of the approximated sum of products
+};
 
-		//== print current result
-		if (isPrLocal) {
-			chrR.Increment(len, 0);
-			PrintMngr::PrintCC(chrR.PCC(), c.first);
+// Prints chrom results and reduces them to the total one
+//	@cIDs: treated chroms
+//	@chrRs: chrom results in the order of cIDs
+//	@templ: template to define treated regions
+//	return: true if calculation was actually done
+bool PlainCover::PrintChromRs(const vector<chrid>& cIDs, vector<ChromR>& chrRs, const Features* templ)
+{
+	// reduce chrom results in a fixed chrom order, so the total coefficient does not depend on the number of threads
+	spR totR;
+	double totErr = 0;		// bound of the error of the total approximated sum of products
+	bool done = false;
+	for (size_t i = 0; i < cIDs.size(); i++) {
+		ChromR& chrR = chrRs[i];
+		if (PrintMngr::IsPrintLocal()) {
+			if (templ)
+				chrR.LocResults.Print(_printFRes, _binWidth);
+			PrintMngr::PrintCC(chrR.R.PCC(), cIDs[i], _approx ? chrR.R.Deviation(chrR.ErrXY) : -1);
+			done = true;
 		}
-		if (isPrTotal)
-			totR.Increment(len, 0);
+		if (PrintMngr::IsPrintTotal())
+			totR.Add(chrR.R), totErr += chrR.ErrXY;
 	}
-	if (isPrTotal)
-		PrintMngr::PrintCC(totR.PCC());
-
-	return chrR.IsDone() || totR.IsDone();
+	if (PrintMngr::IsPrintTotal())
+		PrintMngr::PrintCC(totR.PCC(), Chrom::UnID, _approx ? totR.Deviation(totErr) : -1);
+	return done || totR.IsDone();
 }
 
-#ifdef _DEBUG
-void	JointedBeds::Print()
+// Calculates chrom results on the threads
+//	@cv: compared cover
+//	@cIDs: chroms presented in both covers
+//	@templ: template to define treated regions; ignored for the approximated or dense layout
+//	@fillLocRes: true if coefficients of the template features should be filled
+//	@chrRs: filled chrom results in the order of cIDs
+void PlainCover::FillChromRs(const PlainCover& cv, const vector<chrid>& cIDs, const Features* templ,
+	bool fillLocRes, vector<ChromR>& chrRs) const
 {
-	cout << "JointedBeds:\n";
-	for (cIter it = cBegin(); it != cEnd(); it++) {
-		cout << Chrom::AbbrName(CID(it)) << COLON;
-		for (auto ri = Data(it).FirstInd; ri <= Data(it).LastInd; ri++)
-			cout << TAB << _ranges[ri].Start << TAB << int(_ranges[ri].Val) << LF;
+	chrRs.resize(cIDs.size());
+	if (_approx) {		// template is not applied
+		Workers::Run(cIDs.size(), [&](size_t i) {
+			chrRs[i].ErrXY = CalcChromR(*_pyramid, *cv._pyramid, cIDs[i], _approx - 1, chrRs[i].R);
+		});
+		return;
+	}
+	if (_binned) {		// dense layout; template is not applied
+		Workers::Run(cIDs.size(), [&](size_t i) { CalcChromR(*_binned, *cv._binned, cIDs[i], chrRs[i].R); });
+		return;
 	}
-}
-#endif
-/************************ end of class JointedBeds ************************/
 
-/************************ class CorrPair ************************/
+	// 'Unit' is the part of the chrom treated at once: the whole chrom or the span of its template features
+	struct Unit
+	{
+		size_t	ChrInd;		// index of the chrom in cIDs
+		unique_ptr<FeatureSpan> Span;	// template features, or NULL if template is not defined
+		ChromR	Result;
 
-CorrPair::FileType CorrPair::_FileTypes[] = {
-	{ &CorrPair::CreateWig,  [](void* obj) { delete (Cover*)obj; }},
-	{ &CorrPair::CreateBedF, [](void* obj) { delete (Features*)obj; }},
-	{ &CorrPair::CreateBedR, [](void* obj) { delete (ReadDens*)obj; }}
-};
+		Unit(size_t chrInd, FeatureSpan* span) : ChrInd(chrInd), Span(span) {}
+	};
+	vector<Unit> units;
 
-// Creates an instance with checking primary object.
-//	@cID: chromosome's ID
-//	@primefName: primary file's name
-//	@rgns: genome regions
-//	@tfName: name of template bed file, or NULL if undefined
-//	@multiFiles: true if more then one secondary files are placed
-CorrPair::CorrPair(const char* primefName, DefRegions& rgns, const char* tfName, bool multiFiles) :
-	_gRgns(rgns),
-	_typeInd(CheckFileExt(primefName, true))
-{
-	const char* sTemplate = "template";
+	units.reserve(cIDs.size());
+	for (size_t i = 0; i < cIDs.size(); i++)
+		if (templ) {
+			vector<FeatureSpan> spans;
+			SplitFeatures(*templ, cIDs[i], spans);
+			for (const auto& span : spans)
+				units.emplace_back(i, new FeatureSpan(span));
+		}
+		else
+			units.emplace_back(i, nullptr);
+
+	// chroms and spans of features are treated independently, so they can be distributed among the threads
+	Workers::Run(units.size(), [&](size_t i) {
+		Unit& unit = units[i];
+		CalcChromR(*this, cv, cIDs[unit.ChrInd], unit.Span.get(),
+			unit.Result.R, fillLocRes ? &unit.Result.LocResults : nullptr);
+	});
+	// collect units results in a fixed order
+	for (const auto& unit : units) {
+		ChromR& chrR = chrRs[unit.ChrInd];
+		chrR.R.Add(unit.Result.R);
+		chrR.LocResults.Append(unit.Result.LocResults);
+	}
+}
+
+// Calculates and prints corr. coefficients, using single-pass range-based algorithm
+//	@cv: compared cover
+//	@gRgns: def regions (chrom sizes)
+//	@templ: template to define treated regions
+//	return: true if calculation was actually done
+bool PlainCover::CalcR(const PlainCover& cv, const DefRegions& rgns, const Features* templ)
+{
+#ifdef _DEBUG
+	//Print("first", 0);
+	//cv.Print("second", 0);	cout << LF;
+	////rgns.Print();
+	//if (templ)	templ->Print();
+#endif
+	// rgns is already limited by chroms represented in template, if it's defined
+	vector<chrid> cIDs;			// common chroms in the order of rgns
+	cIDs.reserve(rgns.Count());
+	for (auto rit = rgns.cBegin(); rit != rgns.cEnd(); rit++)
+		if (GetIter(CID(rit)) != cEnd() && cv.GetIter(CID(rit)) != cv.cEnd())
+			cIDs.push_back(CID(rit));
+	vector<ChromR> chrRs;
+
+	FillChromRs(cv, cIDs, templ, templ && (_binWidth || _printFRes), chrRs);
+	return PrintChromRs(cIDs, chrRs, _approx || _binned ? nullptr : templ);
+}
+
+// 'AnyCursor' sequentially reads chrom's items regardless of the cover layout
+class AnyCursor
+{
+	typedef PlainCover::PlainCursor		Plain;
+	typedef PlainCover::PackedCursor	Packed;
+
+	Plain	_plain;
+	unique_ptr<Packed>	_packed;	// cursor in compact layout, or NULL
+public:
+	AnyCursor(const PlainCover& cv, chrid cID) : _plain(nullptr, nullptr) {
+		if (cv.IsPacked())	_packed.reset(new Packed(cv, cID));
+		else				_plain = Plain(cv, cID);
+	}
+
+	bool IsEnd() const { return _packed ? _packed->IsEnd() : _plain.IsEnd(); }
+
+	const ValPos* operator->() const { return _packed ? _packed->operator->() : _plain.operator->(); }
+
+	AnyCursor& operator++() {
+		if (_packed)	++*_packed;
+		else			++_plain;
+		return *this;
+	}
+
+	void SeekTo(chrlen pos, float& val) {
+		if (_packed)	_packed->SeekTo(pos, val);
+		else			_plain.SeekTo(pos, val);
+	}
+};
+
+// Accumulates sums of the cover and several compared covers within the chrom.
+// Each compared cover has its own merge, and the merges are kept contiguously. They pass the cover
+// block by block, so its items are read from memory once and then from cache.
+// Each merge accumulates its sums in the same order as the pairwise kernel, so the results are identical.
+//	@withTempl: true if template is defined
+//	@withLoc: true if coefficients of the template features should be filled; requires withTempl
+//	@itX: first cover's chrom cursor
+//	@itYs: compared covers' chrom cursors; are moved to the merges
+//	@fSpan: treated template features; ignored if withTempl is false
+//	@chrRs: chrom results for each compared cover
+template<bool withTempl, bool withLoc, typename CX>
+void CalcChromRs(const CX& itX, vector<AnyCursor>& itYs, const FeatureSpan* fSpan, ChromR* chrRs)
+{
+	const chrlen blockLen = 1 << 16;	// length of the cover's region passed by all the merges in turn
+	vector<ChromMerge<withTempl, withLoc, CX, AnyCursor>> merges;
+
+	merges.reserve(itYs.size());
+	for (size_t i = 0; i < itYs.size(); i++)
+		merges.emplace_back(itX, move(itYs[i]), fSpan, chrRs[i].R, withLoc ? &chrRs[i].LocResults : nullptr);
+	for (chrlen lim = blockLen; ; lim = lim < CHRLEN_UNDEF - blockLen ? lim + blockLen : CHRLEN_UNDEF) {
+		bool run = false;	// true if any merge is not finished
+		for (auto& merge : merges)
+			run |= merge.Run(lim);
+		if (!run)	break;
+	}
+}
+
+// Accumulates sums of the cover and several compared covers within the chrom,
+// calling the kernel specialized by the template usage
+//	@itX: first cover's chrom cursor
+//	@itYs: compared covers' chrom cursors; are moved to the merges
+//	@fSpan: treated template features, or NULL if template is not defined
+//	@fillLoc: true if coefficients of the template features should be filled
+//	@chrRs: chrom results for each compared cover
+template<typename CX>
+void CalcChromRs(const CX& itX, vector<AnyCursor>& itYs, const FeatureSpan* fSpan, bool fillLoc, ChromR* chrRs)
+{
+	if (!fSpan)
+		CalcChromRs<false, false>(itX, itYs, fSpan, chrRs);
+	else if (fillLoc)
+		CalcChromRs<true, true>(itX, itYs, fSpan, chrRs);
+	else
+		CalcChromRs<true, false>(itX, itYs, fSpan, chrRs);
+}
+
+// Calculates and prints corr. coefficients with several compared covers in a single pass through this cover
+//	@cvs: compared covers
+//	@gRgns: def regions (chrom sizes)
+//	@templ: template to define treated regions
+//	@print: function called for each compared cover in turn with its index
+//	and the function printing its results, which returns true if calculation was actually done
+void PlainCover::CalcR(const vector<const PlainCover*>& cvs, const DefRegions& rgns, const Features* templ,
+	const function<void(size_t, const function<bool()>&)>& print)
+{
+	if (_binned || _approx) {	// the bins or windows are compared directly, so there is no merge to share
+		for (size_t i = 0; i < cvs.size(); i++)
+			print(i, [&]() { return CalcR(*cvs[i], rgns, templ); });
+		return;
+	}
+	const bool fillLocRes = templ && (_binWidth || _printFRes);
+
+	// 'Unit' is the part of the chrom treated at once with all the compared covers presented in it:
+	// the whole chrom or the span of its template features, the same as for the pairwise calculation
+	struct Unit
+	{
+		size_t	ChrInd;			// index of the chrom in cIDs
+		unique_ptr<FeatureSpan> Span;	// template features, or NULL if template is not defined
+		vector<size_t>	CvInds;	// indexes of the compared covers
+		vector<ChromR>	Results;	// results in the order of CvInds
+
+		Unit(size_t chrInd, FeatureSpan* span, const vector<size_t>& cvInds)
+			: ChrInd(chrInd), Span(span), CvInds(cvInds), Results(cvInds.size()) {}
+	};
+	vector<chrid> cIDs;			// chroms presented in this cover and in any compared one
+	vector<Unit> units;
+
+	// rgns is already limited by chroms represented in template, if it's defined
+	for (auto rit = rgns.cBegin(); rit != rgns.cEnd(); rit++) {
+		const chrid cID = CID(rit);
+		vector<size_t> cvInds;
+
+		if (GetIter(cID) == cEnd())	continue;
+		for (size_t i = 0; i < cvs.size(); i++)
+			if (cvs[i]->GetIter(cID) != cvs[i]->cEnd())
+				cvInds.push_back(i);
+		if (cvInds.empty())	continue;
+		cIDs.push_back(cID);
+		if (templ) {
+			vector<FeatureSpan> spans;
+			SplitFeatures(*templ, cID, spans);
+			for (const auto& span : spans)
+				units.emplace_back(cIDs.size() - 1, new FeatureSpan(span), cvInds);
+		}
+		else
+			units.emplace_back(cIDs.size() - 1, nullptr, cvInds);
+	}
+
+	// chroms and spans of features are treated independently, so they can be distributed among the threads
+	Workers::Run(units.size(), [&](size_t u) {
+		Unit& unit = units[u];
+		const chrid cID = cIDs[unit.ChrInd];
+		vector<AnyCursor> itYs;
+
+		itYs.reserve(unit.CvInds.size());
+		for (const size_t i : unit.CvInds)
+			itYs.emplace_back(*cvs[i], cID);
+		if (IsPacked())
+			CalcChromRs(PackedCursor(*this, cID), itYs, unit.Span.get(), fillLocRes, unit.Results.data());
+		else
+			CalcChromRs(PlainCursor(*this, cID), itYs, unit.Span.get(), fillLocRes, unit.Results.data());
+	});
+
+	// collect and print the results of each compared cover, reducing units in a fixed order
+	for (size_t i = 0; i < cvs.size(); i++) {
+		vector<chrid> cvIDs;
+		vector<ChromR> chrRs;
+
+		for (const auto& unit : units) {
+			const auto it = find(unit.CvInds.begin(), unit.CvInds.end(), i);
+			if (it == unit.CvInds.end())	continue;
+			if (cvIDs.empty() || cvIDs.back() != cIDs[unit.ChrInd]) {
+				cvIDs.push_back(cIDs[unit.ChrInd]);
+				chrRs.emplace_back();
+			}
+			const ChromR& res = unit.Results[it - unit.CvInds.begin()];
+			chrRs.back().R.Add(res.R);
+			chrRs.back().LocResults.Append(res.LocResults);
+		}
+		print(i, [&]() { return PrintChromRs(cvIDs, chrRs, templ); });
+	}
+}
+
+// 'StreamR' calculates chrom results as soon as the compared cover's chrom is read.
+// Chroms are treated on the Workers queue, so reading and calculation overlap even for a single thread;
+// the number of chroms kept at once is limited by the number of threads plus one waiting chrom.
+class StreamR : public ChromSink
+{
+	// 'Job' keeps chrom's items until they are treated
+	struct Job
+	{
+		vector<ValPos>	Items;		// chrom's items buffer
+		ChromR			Result;
+	};
+
+	const PlainCover& _cv;		// resident cover
+	const DefRegions& _rgns;
+	const Features* _templ;
+	const bool		_fillLocRes;
+	map<chrid, unique_ptr<Job>> _jobs;	// treated chroms
+	Workers::Queue	_queue;				// should be destroyed first, since its jobs refer to _jobs
+
+public:
+	StreamR(const PlainCover& cv, const DefRegions& rgns, const Features* templ, bool fillLocRes)
+		: _cv(cv), _rgns(rgns), _templ(templ), _fillLocRes(fillLocRes) {}
+
+	// Treats chrom's items in the background
+	void operator()(chrid cID, vector<ValPos>&& items, size_t first)
+	{
+		// rgns is already limited by chroms represented in template, if it's defined
+		if (_rgns.GetIter(cID) == _rgns.cEnd() || _cv.GetIter(cID) == _cv.cEnd() || _jobs.count(cID))
+			return;
+		Job* job = (_jobs[cID] = unique_ptr<Job>(new Job)).get();
+		job->Items.swap(items);
+		_queue.Push([=]() {		// waits while all the threads are busy and a chrom is already waiting
+			CalcChromR(_cv, job->Items.data() + first, job->Items.data() + job->Items.size(),
+				cID, _templ, job->Result.R, _fillLocRes ? &job->Result.LocResults : nullptr);
+			vector<ValPos>().swap(job->Items);		// release items
+		});
+	}
+
+	// Waits for all the jobs and returns their results in the order of rgns
+	//	@cIDs: treated chroms
+	//	@chrRs: chrom results in the order of cIDs
+	void Complete(vector<chrid>& cIDs, vector<ChromR>& chrRs)
+	{
+		_queue.Wait();
+		for (auto rit = _rgns.cBegin(); rit != _rgns.cEnd(); rit++) {
+			auto it = _jobs.find(CID(rit));
+			if (it == _jobs.end())	continue;
+			cIDs.push_back(CID(rit));
+			chrRs.push_back(move(it->second->Result));
+		}
+	}
+};
+
+// Calculates and prints corr. coefficients with the cover which is not kept in memory:
+// its chroms are merged with this cover as soon as they are read
+//	@read: function reading compared cover chroms into the given sink
+//	@gRgns: def regions (chrom sizes)
+//	@templ: template to define treated regions
+//	return: true if calculation was actually done
+bool PlainCover::CalcR(const function<void(ChromSink&)>& read, const DefRegions& rgns, const Features* templ)
+{
+	StreamR sink(*this, rgns, templ, templ && (_binWidth || _printFRes));
+	vector<chrid> cIDs;			// common chroms in the order of rgns
+	vector<ChromR> chrRs;
+
+	read(sink);
+	sink.Complete(cIDs, chrRs);
+	return PrintChromRs(cIDs, chrRs, templ);
+}
+
+// Calculates corr. coefficients without printing
+//	@cv: compared cover
+//	@cIDs: treated chroms
+//	@templ: template to define treated regions
+//	@ccs: filled chrom coefficients in the order of cIDs (Undef for uncommon chrom), followed by the total one
+void PlainCover::CalcR(const PlainCover& cv, const vector<chrid>& cIDs, const Features* templ, float* ccs) const
+{
+	spR totR;
+	bool done = false;		// true if at least one chrom is treated
+
+	for (const chrid cID : cIDs) {
+		if (GetIter(cID) == cEnd() || cv.GetIter(cID) == cv.cEnd()
+		|| (templ && templ->GetIter(cID) == templ->cEnd())) {
+			*ccs++ = Undef;
+			continue;
+		}
+		spR chrR;
+		if (_approx)		CalcChromR(*_pyramid, *cv._pyramid, cID, _approx - 1, chrR);
+		else if (_binned)	CalcChromR(*_binned, *cv._binned, cID, chrR);
+		else				CalcChromR(*this, cv, cID, templ, chrR, nullptr);
+		*ccs++ = chrR.PCC();
+		totR.Add(chrR);
+		done = true;
+	}
+	*ccs = done ? totR.PCC() : Undef;
+}
+
+// Writes chrom's valued intervals to BEDGRAPG file
+//	@file: opened file
+//	@chr: chrom's name
+//	@it: chrom's cursor
+template<typename C>
+void WriteChrom(ofstream& file, const string& chr, C it)
+{
+	if (it.IsEnd())		return;
+	for (ValPos prev = *it; !(++it).IsEnd(); prev = *it)
+		if (prev.Val)
+			file << chr << TAB << prev.Pos << TAB << it->Pos << TAB << prev.Val << LF;
+}
+
+// Writes inner representation to BEDGRAPG file
+void PlainCover::Write(const string& fName) const
+{
+	ofstream file;
+	file.open(fName);
+	file << "track type=bedGraph\n";
+	for (const auto& c : Container()) {
+		const string& chr = Chrom::AbbrName(c.first);
+		if (IsPacked())	WriteChrom(file, chr, PackedCursor(*this, c.first));
+		else			WriteChrom(file, chr, PlainCursor(*this, c.first));
+	}
+	file.close();
+}
+
+// Converts items to compact layout and releases the plain ones; items in mapped layout remain as they are
+void PlainCover::Pack()
+{
+	if (IsPacked() || _mapped)	return;
+	_packed.reset(new PackedItems(*this));
+	vector<ValPos>().swap(_items);
+}
+
+// Converts items to dense layout and releases the items in any other layout
+//	@binLen: length of bin
+//	@cSizes: chrom sizes
+void PlainCover::Bin(chrlen binLen, const ChromSizes& cSizes)
+{
+	_binned.reset(new BinnedItems(*this, binLen, cSizes));
+	_pyramid.reset();		// it can refer to the mapped cache
+	_packed.reset();
+	_mapped.reset();
+	_mappedItems = nullptr;
+	_mappedCnt = 0;
+	vector<ValPos>().swap(_items);
+}
+
+// Forces coefficients to be approximated by the pyramid, building it if it is absent
+//	@level: level of the pyramid
+void PlainCover::Approximate(BYTE level)
+{
+	if (!_pyramid)	_pyramid.reset(new Pyramid(*this));
+	_approx = level + 1;
+}
+
+// Calculates coefficients in sliding windows and writes them as bedGraph track.
+// Each window is represented by its central part of the step length.
+//	@cv: compared cover
+//	@gRgns: def regions (chrom sizes)
+//	@winLen: length of window
+//	@step: step of window
+//	@file: output file
+//	@name: track name
+void PlainCover::WriteWinR(const PlainCover& cv, const DefRegions& rgns,
+	chrlen winLen, chrlen step, ofstream& file, const char* name) const
+{
+	typedef PlainCover::PlainCursor		Plain;
+	typedef PlainCover::PackedCursor	Packed;
+
+	vector<chrid> cIDs;			// common chroms in the order of rgns
+	for (auto rit = rgns.cBegin(); rit != rgns.cEnd(); rit++)
+		if (GetIter(CID(rit)) != cEnd() && cv.GetIter(CID(rit)) != cv.cEnd())
+			cIDs.push_back(CID(rit));
+	vector<vector<pair<chrlen, float>>> chromRes(cIDs.size());
+
+	Workers::Run(cIDs.size(), [&](size_t i) {
+		const chrid cID = cIDs[i];
+		auto& res = chromRes[i];
+
+		if (IsPacked())
+			if (cv.IsPacked())	CalcChromWinR(Packed(*this, cID), Packed(cv, cID), winLen, step, res);
+			else				CalcChromWinR(Packed(*this, cID), Plain(cv, cID), winLen, step, res);
+		else
+			if (cv.IsPacked())	CalcChromWinR(Plain(*this, cID), Packed(cv, cID), winLen, step, res);
+			else				CalcChromWinR(Plain(*this, cID), Plain(cv, cID), winLen, step, res);
+	});
+
+	const chrlen offset = winLen > step ? (winLen - step) / 2 : 0;	// offset of the window central part
+	file << "track type=bedGraph name=\"" << name << "\"\n";
+	for (size_t i = 0; i < cIDs.size(); i++) {
+		const string& chr = Chrom::AbbrName(cIDs[i]);
+		for (const auto& r : chromRes[i])
+			file << chr << TAB << r.first + offset << TAB << r.first + offset + step << TAB << r.second << LF;
+	}
+}
+
+// Prints memory occupied by one interval
+void PlainCover::PrintMemUsage() const
+{
+	if (_binned) {
+		dout << SPACE << _binned->Count() << " bins of " << _binned->BinLen() << " bp, "
+			<< setprecision(3) << float(_binned->Count() * sizeof(float)) / (1 << 20) << " MB" << LF;
+		return;
+	}
+	if (_approx) {
+		dout << SPACE << _pyramid->Count() << " windows";
+		if (_mapped)	dout << " (mapped cache)";
+		dout << LF;
+		return;
+	}
+	size_t cnt = 0;		// number of intervals
+	for (const auto& c : Container()) {
+		const auto& rng = IsPacked() ? _packed->Range(c.first) :
+			pair<size_t, size_t>(c.second.Data.FirstInd, c.second.Data.LastInd);
+		cnt += rng.second - rng.first;
+	}
+	if (!cnt)	return;
+	const size_t size = IsPacked() ? _packed->MemSize() : 
+		(_mapped ? _mappedCnt : _items.capacity()) * sizeof(ValPos);
+	dout << SPACE << setprecision(3) << float(size) / cnt << " bytes per interval";
+	if (IsPacked())
+		dout << " (compact layout" << (_packed->IsDictCoded() ? ", dictionary-coded values)" : ")");
+	else if (_mapped)
+		dout << " (mapped cache)";
+	dout << LF;
+}
+
+/************************ dense layout ************************/
+
+// Fills chrom's bins by the mean values of the cover
+//	@it: chrom's cursor
+//	@binLen: length of bin
+//	@bins: chrom's bins
+template<typename C>
+void FillBins(C it, chrlen binLen, vector<float>& bins, chrlen cSize)
+{
+	chrlen pos = 0, binEnd = min(binLen, cSize);	// current position, current bin end
+	float val = 0;		// current value
+	double sum = 0;		// sum of the values in the current bin
+	size_t bInd = 0;	// current bin index
+
+	// Adds current value to the bins up to the position
+	auto add = [&](chrlen end) {
+		while (pos < end) {
+			const chrlen stop = min(end, binEnd);
+			sum += double(val) * (stop - pos);
+			pos = stop;
+			if (pos == binEnd) {		// close bin
+				bins[bInd] = float(sum / (binEnd - bInd * binLen));
+				sum = 0;
+				binEnd = min(binEnd + binLen, cSize);
+				bInd++;
+			}
+		}
+	};
+
+	for (; !it.IsEnd(); ++it) {
+		add(min(it->Pos, cSize));
+		val = it->Val;
+	}
+	add(cSize);
+}
+
+// Creates dense representation of cover items
+//	@cv: cover
+//	@binLen: length of bin
+//	@cSizes: chrom sizes
+PlainCover::BinnedItems::BinnedItems(const PlainCover& cv, chrlen binLen, const ChromSizes& cSizes)
+	: _binLen(binLen)
+{
+	for (const auto& c : cv.Container()) {
+		const chrlen cSize = cSizes[c.first];
+		vector<float>& bins = _chroms[c.first];
+
+		bins.resize((cSize + binLen - 1) / binLen);
+		if (cv.IsPacked())	FillBins(PackedCursor(cv, c.first), binLen, bins, cSize);
+		else				FillBins(PlainCursor(cv, c.first), binLen, bins, cSize);
+	}
+}
+
+// Returns number of bins
+size_t PlainCover::BinnedItems::Count() const
+{
+	size_t cnt = 0;
+	for (const auto& c : _chroms)	cnt += c.second.size();
+	return cnt;
+}
+
+/************************ pyramid ************************/
+
+const chrlen PlainCover::Pyramid::WinLens[] = { 1000, 10000, 100000 };
+
+// Fills chrom's windows of the lowest level
+//	@it: chrom's cursor
+//	@wins: filled windows
+//	return: chrom length
+template<typename C>
+chrlen FillWindows(C it, vector<PlainCover::Pyramid::WinSums>& wins)
+{
+	const chrlen winLen = PlainCover::Pyramid::WinLens[0];
+	chrlen pos = 0, winEnd = winLen;	// current position, current window end
+	float val = 0;						// current value
+	PlainCover::Pyramid::WinSums ws{ 0, 0 };	// current window sums
+
+	for (; !it.IsEnd(); ++it) {
+		const chrlen end = it->Pos;
+		while (pos < end) {
+			const chrlen stop = min(end, winEnd);
+			const double valLen = double(val) * (stop - pos);
+
+			ws.Sum += valLen;
+			ws.SumSqr += valLen * val;
+			if ((pos = stop) == winEnd) {	// close window
+				wins.push_back(ws);
+				ws = { 0, 0 };
+				winEnd += winLen;
+			}
+		}
+		val = it->Val;
+	}
+	if (pos % winLen)	wins.push_back(ws);	// the last incomplete window
+	return pos;
+}
+
+// Returns number of windows of the chrom on all levels
+//	@len: chrom length
+size_t PlainCover::Pyramid::WinCount(chrlen len)
+{
+	size_t cnt = 0;
+	for (BYTE i = 0; i < LevelCnt; i++)	cnt += WinCount(len, i);
+	return cnt;
+}
+
+// Creates pyramid of cover items
+//	@cv: cover
+PlainCover::Pyramid::Pyramid(const PlainCover& cv)
+{
+	vector<pair<chrid, size_t>> firsts;	// index of the first window for each chrom
+
+	for (const auto& c : cv.Container()) {
+		vector<WinSums> wins;
+		const chrlen len = cv.IsPacked() ?
+			FillWindows(PackedCursor(cv, c.first), wins) :
+			FillWindows(PlainCursor(cv, c.first), wins);
+
+		firsts.emplace_back(c.first, _data.size());
+		_data.insert(_data.end(), wins.begin(), wins.end());
+		// each upper level window consolidates the lower level windows
+		for (BYTE i = 1; i < LevelCnt; i++) {
+			const size_t ratio = WinLens[i] / WinLens[i - 1];
+			const size_t lowCnt = WinCount(len, i - 1);
+			const size_t low = _data.size() - lowCnt;		// first window of the lower level
+
+			for (size_t k = 0; k < lowCnt; k += ratio) {
+				WinSums ws{ 0, 0 };
+				for (size_t j = low + k; j < low + min(k + ratio, lowCnt); j++)
+					ws.Sum += _data[j].Sum, ws.SumSqr += _data[j].SumSqr;
+				_data.push_back(ws);
+			}
+		}
+		_chroms[c.first] = { len, nullptr };
+	}
+	for (const auto& f : firsts)		// the data is complete, so it will not be reallocated
+		_chroms[f.first].Data = _data.data() + f.second;
+}
+
+// Returns chrom's windows on the level
+//	@cID: chrom
+//	@level: level
+const PlainCover::Pyramid::WinSums* PlainCover::Pyramid::Windows(chrid cID, BYTE level) const
+{
+	const ChromWins& cw = _chroms.at(cID);
+	const WinSums* data = cw.Data;
+
+	for (BYTE i = 0; i < level; i++)	data += WinCount(cw.Length, i);
+	return data;
+}
+
+// Returns number of windows on all levels
+size_t PlainCover::Pyramid::Count() const
+{
+	size_t cnt = 0;
+	for (const auto& c : _chroms)	cnt += WinCount(c.second.Length);
+	return cnt;
+}
+
+/************************ cache ************************/
+
+// 'CacheHeader' is the header of the cache file.
+// It is followed by the chrom table, by the items of all chroms in the table order,
+// and by the pyramid windows of all chroms in the same order, if the pyramid is kept.
+// The file keeps the native layout, so it is not intended to be moved between platforms.
+struct CacheHeader
+{
+	char		Sign[8];	// file signature
+	UINT		Version;	// format version
+	UINT		ChromCnt;	// number of chroms
+	CacheKey	Key;		// source file key
+};
+
+// 'CacheChrom' is the chrom table entry
+struct CacheChrom
+{
+	size_t	Count;		// number of chrom's items
+	chrid	ID;			// chrom ID
+	chrlen	Length;		// chrom length covered by the pyramid, or 0 if the pyramid is not kept
+};
+
+static const char CacheSign[8] = { 'b','i','o','C','C','c','v','\0' };
+static const UINT CacheVersion = 4;
+
+// Returns offset of the items in the cache file
+//	@cCnt: number of chroms
+inline size_t CacheItemsOffset(size_t cCnt)
+{
+	// the items are aligned as the pyramid windows following them
+	const size_t align = max(alignof(ValPos), alignof(PlainCover::Pyramid::WinSums));
+	const size_t offset = sizeof(CacheHeader) + cCnt * sizeof(CacheChrom);
+	return (offset + align - 1) / align * align;
+}
+
+// Initializes cache key if caching is required
+//	@key: initialized key
+//	@fName: source file name
+//	@cSizes: chrom sizes
+//	@dupl: duplicates permission, or 0 if not applicable
+//	return: true if caching is required and possible
+bool PlainCover::InitCacheKey(CacheKey& key, const char* fName, const ChromSizes& cSizes, BYTE dupl)
+{
+	// the chrom sizes initialized by the source itself cannot be restored from the cache
+	return Options::GetBVal(oCACHE) && cSizes.IsFilled()
+		&& key.Init(fName, cSizes, dupl);
+}
+
+// Initializes instance from the cache file in mapped layout.
+// The whole genome cache serves the user-defined chrom as well: the chrom table is the index
+// of the chroms' items, so only the items of the stated chrom are mapped, and the source is not read.
+//	@fName: source file name
+//	@key: source file key
+//	@oinfo: verbose level
+//	return: true if cache file exists and matches the key
+bool PlainCover::LoadCache(const char* fName, const CacheKey& key, eOInfo oinfo)
+{
+	unique_ptr<MappedFile> file(new MappedFile(CacheKey::FileName(fName)));
+	if (!file->IsValid() || file->Size() < sizeof(CacheHeader))	return false;
+
+	const CacheHeader& head = *(const CacheHeader*)file->Data();
+	CacheKey headKey = head.Key;
+	const bool whole = headKey.UserCID == Chrom::UnID;	// true if the cache keeps all the chroms
+	if (whole)	headKey.UserCID = key.UserCID;
+	if (memcmp(head.Sign, CacheSign, sizeof(CacheSign)) || head.Version != CacheVersion
+	|| !(headKey == key))
+		return false;
+	const size_t offset = CacheItemsOffset(head.ChromCnt);
+	if (file->Size() < offset)	return false;
+
+	// chrom table
+	const CacheChrom* chroms = (const CacheChrom*)(file->Data() + sizeof(CacheHeader));
+	size_t cnt = 0, winCnt = 0;
+	for (UINT i = 0; i < head.ChromCnt; i++) {
+		cnt += chroms[i].Count;
+		winCnt += Pyramid::WinCount(chroms[i].Length);
+	}
+	if (file->Size() != offset + cnt * sizeof(ValPos) + winCnt * sizeof(Pyramid::WinSums))	return false;
+	if (winCnt)		_pyramid.reset(new Pyramid);
+	const Pyramid::WinSums* wins = (const Pyramid::WinSums*)(file->Data() + offset + cnt * sizeof(ValPos));
+	size_t first = 0;		// index of the first chrom's item
+	cnt = 0;
+	for (UINT i = 0; i < head.ChromCnt; i++) {
+		if (!whole || key.UserCID == Chrom::UnID || chroms[i].ID == key.UserCID) {
+			AddVal(chroms[i].ID, ItemIndices(first, first + chroms[i].Count));
+			cnt += chroms[i].Count;
+			if (winCnt)	_pyramid->AddChrom(chroms[i].ID, chroms[i].Length, wins);
+		}
+		first += chroms[i].Count;
+		wins += Pyramid::WinCount(chroms[i].Length);
+	}
+	if (!cnt) {				// the stated chrom is absent in the cache; let the source report it
+		_pyramid.reset();
+		return false;
+	}
+	// items are paged in only for the chroms that are actually treated
+	_mappedItems = (const ValPos*)(file->Data() + offset);
+	_mappedCnt = cnt;
+	_mapped = move(file);
+
+	if (oinfo > eOInfo::NONE) {
+		dout << fName;
+		if (oinfo >= eOInfo::STD)
+			dout << COLON << SPACE << cnt << SPACE << FT::ItemTitle(FT::eType::BGRAPH, cnt != 1) << " (cached)";
+		if (oinfo > eOInfo::NM)	dout << LF;
+	}
+	return true;
+}
+
+// Saves items to the cache file, and their pyramid if the approximation is requested
+//	@fName: source file name
+//	@key: source file key
+void PlainCover::SaveCache(const char* fName, const CacheKey& key)
+{
+	const string cName = CacheKey::FileName(fName);
+	// the cache file appears only when it is complete; concurrent writers do not share the temporary file
+	const string tmpName = CacheKey::TmpFileName(cName);
+	CacheHeader head{};		// the padding does not matter: the header is checked by fields
+	vector<CacheChrom> chroms;
+	ofstream file(tmpName, ios::binary);
+
+	if (!file)	return;		// the cache is optional: the source directory may be read-only
+	if (!_pyramid && Options::Assigned(oAPPROX))
+		_pyramid.reset(new Pyramid(*this));		// it is reused by Approximate()
+	memcpy(head.Sign, CacheSign, sizeof(CacheSign));
+	head.Version = CacheVersion;
+	head.ChromCnt = UINT(Container().size());
+	head.Key = key;
+	chroms.reserve(head.ChromCnt);
+	for (const auto& c : Container())
+		chroms.push_back({ c.second.Data.ItemsCount(), c.first, _pyramid ? _pyramid->Length(c.first) : 0 });
+	file.write((const char*)&head, sizeof(head));
+	file.write((const char*)chroms.data(), chroms.size() * sizeof(CacheChrom));
+	for (size_t i = sizeof(head) + chroms.size() * sizeof(CacheChrom); i < CacheItemsOffset(chroms.size()); i++)
+		file.put(0);
+	for (const auto& c : Container())
+		file.write((const char*)(_items.data() + c.second.Data.FirstInd), c.second.Data.ItemsCount() * sizeof(ValPos));
+	if (_pyramid)
+		for (const auto& c : chroms)
+			file.write((const char*)_pyramid->Windows(c.ID, 0), Pyramid::WinCount(c.Length) * sizeof(Pyramid::WinSums));
+	file.close();
+	if (file) {
+		remove(cName.c_str());
+		if (!rename(tmpName.c_str(), cName.c_str()))	return;
+	}
+	remove(tmpName.c_str());
+}
+
+// Passes items in mapped layout to the sink chrom by chrom
+void PlainCover::SinkMapped()
+{
+	for (const auto& c : Container()) {
+		const ValPos* first = _mappedItems + c.second.Data.FirstInd;
+		(*_sink)(c.first, vector<ValPos>(first, first + c.second.Data.ItemsCount()), 0);
+	}
+	_sunkCnt = _mappedCnt;
+}
+
+/************************ end of cache ************************/
+
+/************************ PackedItems ************************/
+
+// Creates compact representation of cover items
+PlainCover::PackedItems::PackedItems(const PlainCover& cv) : _count(cv._items.size())
+{
+	const size_t maxDictSize = 1 << 16;
+	const auto& items = cv._items;
+
+	//== chroms
+	for (const auto& c : cv.Container())
+		_chroms[c.first] = make_pair(
+			size_t(cv.ItemsBegin(c.second.Data) - items.begin()),
+			size_t(cv.ItemsEnd(c.second.Data) - items.begin())
+		);
+
+	//== values
+	unordered_map<float, USHORT> codes;		// value codes
+	for (const auto& item : items)
+		if (codes.find(item.Val) == codes.end()) {
+			if (codes.size() == maxDictSize) {
+				codes.clear();
+				break;
+			}
+			codes.emplace(item.Val, USHORT(codes.size()));
+		}
+	if (codes.size()) {
+		_dict.resize(codes.size());
+		for (const auto& c : codes)		_dict[c.second] = c.first;
+		_codes.reserve(_count);
+		for (const auto& item : items)	_codes.push_back(codes[item.Val]);
+	}
+	else {
+		_vals.reserve(_count);
+		for (const auto& item : items)	_vals.push_back(item.Val);
+	}
+
+	//== positions
+	_blocks.reserve(_count / BlockLen + 1);
+	_deltas.reserve(_count);
+	for (size_t i = 0; i < _count; i++)
+		if (i % BlockLen)
+			// the difference is negative only at the chrom boundary, it's encoded modulo 2^32
+			for (chrlen delta = items[i].Pos - items[i - 1].Pos; ; delta >>= 7)
+				if (delta < 0x80) {
+					_deltas.push_back(BYTE(delta));
+					break;
+				}
+				else
+					_deltas.push_back(BYTE(delta & 0x7F | 0x80));
+		else
+			_blocks.push_back({ items[i].Pos, _deltas.size() });
+	_deltas.shrink_to_fit();
+}
+
+// Decodes block
+//	@bInd: block index
+//	@buf: decoded items
+void PlainCover::PackedItems::Decode(size_t bInd, ValPos* buf) const
+{
+	const size_t first = bInd * BlockLen;
+	const size_t cnt = min(size_t(BlockLen), _count - first);
+	const BYTE* d = _deltas.data() + _blocks[bInd].Offset;
+	chrlen pos = _blocks[bInd].Pos;
+
+	buf[0].Pos = pos;
+	for (size_t i = 1; i < cnt; i++) {
+		chrlen delta = 0;
+		for (BYTE shift = 0; ; shift += 7) {
+			delta |= chrlen(*d & 0x7F) << shift;
+			if (!(*d++ & 0x80))	break;
+		}
+		buf[i].Pos = pos += delta;
+	}
+	if (IsDictCoded())
+		for (size_t i = 0; i < cnt; i++)	buf[i].Val = _dict[_codes[first + i]];
+	else
+		for (size_t i = 0; i < cnt; i++)	buf[i].Val = _vals[first + i];
+}
+
+// Returns occupied memory in bytes
+size_t PlainCover::PackedItems::MemSize() const
+{
+	return _blocks.capacity() * sizeof(Block)
+		+ _deltas.capacity()
+		+ _codes.capacity() * sizeof(USHORT)
+		+ _dict.capacity() * sizeof(float)
+		+ _vals.capacity() * sizeof(float)
+		+ _chroms.size() * (sizeof(chrid) + sizeof(pair<size_t, size_t>));
+}
+
+PlainCover::PackedCursor::PackedCursor(const PlainCover& cv, chrid cID) : _pack(*cv._packed)
+{
+	const auto& rng = _pack.Range(cID);
+	_ind = rng.first;
+	_end = rng.second;
+	if (_ind < _end) {
+		_pack.Decode(_ind / PackedItems::BlockLen, _buf);
+		_bInd = _ind % PackedItems::BlockLen;
+	}
+}
+
+// Moves to the first item with position not less than the given one, using blocks directory
+//	@pos: position
+//	@val: value of the last passed item; is not changed if no item is passed
+void PlainCover::PackedCursor::SeekTo(chrlen pos, float& val)
+{
+	if (IsEnd() || _buf[_bInd].Pos >= pos)	return;
+
+	// search for the last block started before pos; the blocks following the current one lie within the chrom
+	size_t bFirst = _ind / PackedItems::BlockLen, bLast = (_end - 1) / PackedItems::BlockLen;
+	while (bFirst < bLast) {
+		const size_t bMid = (bFirst + bLast + 1) / 2;
+		if (_pack.BlockPos(bMid) < pos)	bFirst = bMid;
+		else							bLast = bMid - 1;
+	}
+	if (bFirst != _ind / PackedItems::BlockLen) {
+		_pack.Decode(bFirst, _buf);
+		_ind = bFirst * PackedItems::BlockLen;
+		_bInd = 0;
+	}
+	// scan the block
+	do {
+		val = _buf[_bInd].Val;
+		++*this;
+	} while (!IsEnd() && _buf[_bInd].Pos < pos);
+}
+
+/************************ end of PackedItems ************************/
+
+/************************ end of PlainCover ************************/
+
+/************************ class Cover ************************/
+
+// Parses unsigned integer without locale and errno overhead.
+// Leading blanks are skipped like atoi does.
+//	@s: pointer to the field; is shifted after the last digit
+//	@val: parsed value
+//	return: false if the field has no digits
+inline bool ParseUInt(const char*& s, chrlen& val)
+{
+	while (isspace(BYTE(*s)))	s++;
+	const char* s0 = s;
+	val = 0;
+	for (BYTE d; (d = BYTE(*s - '0')) < 10; s++)
+		val = val * 10 + d;
+	return s != s0;
+}
+
+// Parses float value.
+// Decimal numbers with no more than 19 significant digits and a small exponent are parsed directly,
+// since the integer mantissa and the power of 10 are exact in double, and the result is rounded once
+// like strtod does. Any other field, including hexadecimal numbers and fields without digits,
+// is passed to strtod, so the result is always the same as strtod gives.
+// Leading blanks are skipped like strtod does.
+//	@s: pointer to the number
+//	return: parsed value
+float ParseFloat(const char* s)
+{
+	static const double pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	while (isspace(BYTE(*s)))	s++;
+	const char* s0 = s;
+	const bool neg = *s == '-';
+	unsigned long long mant = 0;	// mantissa
+	int	dExp = 0;		// decimal exponent
+	BYTE digCnt = 0;	// number of significant digits
+	BYTE d;
+
+	if (neg || *s == '+')	s++;
+	const char* s1 = s;		// start of the digits
+	for (; (d = BYTE(*s - '0')) < 10; s++)
+		if (mant || d)	mant = mant * 10 + d, digCnt++;
+	if (*s == '.')
+		for (s++; (d = BYTE(*s - '0')) < 10; s++, dExp--)
+			if (mant || d)	mant = mant * 10 + d, digCnt++;
+	if (digCnt > 19 || (*s | 0x20) == 'e' || (*s | 0x20) == 'n' || (*s | 0x20) == 'i' || (*s | 0x20) == 'x'
+	|| s - s1 <= (*s1 == '.')		// no digits
+	|| mant >> 53 || dExp < -22)
+		return float(strtod(s0, nullptr));		// rare case
+	const double val = double(mant) / pow10[-dExp];
+	return float(neg ? -val : val);
+}
+
+// Initializes position & value by data line
+//	@vPos: region start position & value
+//	@step: step spec for fixedStep
+//	@s: data line
+//	return: false if the line has no position
+template<bool fixedStep>
+inline bool SetValPos(ValPos& vPos, chrlen step, const char* s);
+
+template<>
+inline bool SetValPos<true>(ValPos& vPos, chrlen step, const char* s)
+{
+	vPos.Pos += step;
+	vPos.Val = ParseFloat(s);
+	return true;
+}
+
+template<>
+inline bool SetValPos<false>(ValPos& vPos, chrlen, const char* s)
+{
+	if (!ParseUInt(s, vPos.Pos))	return false;
+	vPos.Val = ParseFloat(s);
+	return true;
+}
+
+// Initializes instance from wig file
+//	@fixedStep: true for fixedStep format, false for variableStep one
+//	@oinfo: verbose level
+//	return: numbers of all and initialied items for given chrom
+template<bool fixedStep>
+void Cover::InitWiggle(BedReader& file, const char* fName, const ChromSizes& cSizes, eOInfo oinfo)
+{
+	static const string keyChrom = "chrom";
+	static const string keyStart = "start";
+	static const string keyStep = "step";
+	static const string keySpan = "span";
+
+	bool	skipChrom = false;		// if true skip data lines for current chrom
+	chrlen	prevEnd = 0,			// previous region end position, 
+			span = 1, step = 0;		// span spec, step spec (for fixedStep),
+	const char* line;
+	const char firstC = fixedStep ? 'f' : 'v';	// first char of declaration line
+	chrid	cID = Chrom::UnID, nextCID = cID;	// current, next chrom ID
+	ULONG	cItemCnt = 0,	// count of total accepted intervals
+			itemCnt = 0,	// count of accepted intervals of current chrom, total
+			recCnt = 0;		// count of total records
+	ValPos	vPos;			// region start position & value
+	Timer timer(UniBedReader::IsTimer && oinfo > eOInfo::NONE);
+
+	while (line = file.GetNextLine(false))
+		if (*line == firstC) {		// *** declaration line
+			// *** set specifications
+			// ** check keyChrom
+			line = file.ChromMark() - strlen(Chrom::Abbr);					// level the initial value of chrom mark position
+			const char* line1 = line = file.CheckSpec(line, keyChrom) + 1;	// keyChrom initial position
+
+			if (fixedStep) {							// fix declarative parameters
+				// * check keyStart & keyStep
+				vPos.Pos = file.GetIntKey(line1, keyStart);	// initial position
+				line1 += keyStart.length() + 1;			// shift to scan the rest of the line faster
+				step = file.GetIntKey(line1, keyStep);	// initial step
+				vPos.Pos -= step;						// shift 'back' before the first pass, where pos+=step will be invoke
+				line1 += keyStep.length() + 1;			// shift to scan the rest of the line faster
+			}
+			line1 = TabReader::KeyStr(line1, keySpan);
+			span = line1 ? atoi(line1 + 1) : 1;		// initial span: both for fixed- and variableStep
+			// * check chrom
+			if (file.GetNextChrom(nextCID, line)) {
+				if (Chrom::IsSetByUser()) {			// is single chrom specified?
+					if (!fixedStep && vPos.Pos)		// region is initialized: items for the specified chrom are existed and saved
+						break;						// the chrom itself will be saved after loop
+					if (skipChrom = nextCID != Chrom::UserCID())
+						continue;
+				}
+				else {								// all chroms are specified
+					if (cID != Chrom::UnID)			// skip first pass, when curr chrom is still undefined
+						PlainCover::AddChrom(cID, cSizes[cID], prevEnd),
+						itemCnt += cItemCnt;
+				}
+				cID = nextCID;
+				cItemCnt = prevEnd = 0;
+				vPos.Clear();
+			}
+		}
+		else {				// *** data line
+			if (skipChrom)	continue;
+			if (!SetValPos<fixedStep>(vPos, step, file.GetLine()))
+				Err("data line without position: " + string(file.GetLine()), fName).Throw();
+			cItemCnt += AddPos(vPos, prevEnd);
+			prevEnd = vPos.Pos + span;
+			recCnt++;
+		}
+	// save last chrom
+	if (cID != Chrom::UnID) {	// is last chrom valid?
+		PlainCover::AddChrom(cID, cSizes[cID], prevEnd);
+		itemCnt += cItemCnt;
+	}
+	// print stats
+	if (oinfo >= eOInfo::STD) {
+		if (itemCnt == 1)	itemCnt = 0;	// single interval is equal to an empty coverage
+		UniBedReader::PrintItemCount(itemCnt, FT::ItemTitle(FT::eType::WIG_FIX, itemCnt != 1));
+		if (oinfo == eOInfo::STAT)
+			dout << " (" << recCnt << " data lines)";
+		if (!(Timer::Enabled && UniBedReader::IsTimer))	dout << LF;
+	}
+	timer.Stop(1, true);	if (oinfo > eOInfo::NM)	dout << LF;
+}
+
+Cover::Cover(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval, ChromSink* sink)
+	: PlainCover(sink)
+{
+	CacheKey key;
+	const bool cache = InitCacheKey(key, fName, cSizes, 0);
+
+	if (cache && LoadCache(fName, key, oinfo)) {
+		if (sink)	SinkMapped();
+	}
+	else {
+		UniBedReader file(fName, FT::eType::BGRAPH, &cSizes, 4, 0, oinfo, true, abortInval);
+
+		if (!sink)		// in streaming mode only one chrom is kept at once
+			ReserveItems(file.EstItemCount());	// EstItemCount() > 0 even for empty file, because of track line
+		if (file.Type() == FT::eType::BGRAPH)
+			Pass(this, file);
+		else if (file.Type() == FT::eType::WIG_FIX)
+			InitWiggle<true>((BedReader&)file.BaseFile(), fName, cSizes, oinfo);
+		else
+			InitWiggle<false>((BedReader&)file.BaseFile(), fName, cSizes, oinfo);
+		if (cache && !sink && ItemsCount())	SaveCache(fName, key);
+	}
+	
+	if (Options::GetBVal(oWRITE) && !sink) {
+		const string ext = FS::GetExt(fName);
+		Write(FS::FileNameWithoutExt(fName) + "_out." + ext);
+	}
+
+	//PrintEst(file.EstItemCount());
+}
+
+/************************ end of class Cover ************************/
+
+/************************ class ReadDens ************************/
+
+// Adds chrom to the instance
+//	@cID: current chrom ID
+//	@cLen: current chrom length
+void ReadDens::AddChrom(chrid cID, chrlen cLen)
+{
+	auto& fwd = _freqs->Fwd;
+	auto& rev = _freqs->Rev;
+
+	if (!is_sorted(fwd.begin(), fwd.end()))		// unsorted input
+		sort(fwd.begin(), fwd.end());
+	sort(rev.begin(), rev.end());
+
+	// fill items by merging forward and reverse positions
+	const auto itFend = fwd.end();
+	const auto itRend = rev.end();
+	auto itF = fwd.begin();
+	auto itR = rev.begin();
+	chrlen prevEnd = 0;
+	while (itF != itFend || itR != itRend) {
+		const chrlen pos = itR == itRend || (itF != itFend && itF->first <= *itR) ? itF->first : *itR;
+		UINT cnt = 0;
+		for (; itF != itFend && itF->first == pos; itF++)	cnt += itF->second;
+		for (; itR != itRend && *itR == pos; itR++)			cnt++;
+		AddPos(ValPos(pos, float(cnt)), prevEnd);
+		prevEnd = pos + 1;
+	}
+	fwd.clear();		// capacity is kept for the next chrom
+	rev.clear();
+	PlainCover::AddChrom(cID, cLen, prevEnd);
+}
+
+ReadDens::ReadDens(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval, ChromSink* sink)
+	: PlainCover(sink)
+{
+	const BYTE dupl = BYTE(Options::GetRDuplPermit(oDUPL));
+	CacheKey key;
+	const bool cache = InitCacheKey(key, fName, cSizes, dupl);
+
+	if (cache && LoadCache(fName, key, oinfo)) {
+		if (sink)	SinkMapped();
+		return;
+	}
+
+	RBedReader file(fName, &cSizes, dupl, oinfo, abortInval);
+	PosFreqs freqs;
+	_freqs = &freqs;
+
+	if (!sink)		// in streaming mode only one chrom is kept at once
+		ReserveItems(file.EstItemCount());
+	Pass(this, file);
+	_freqs = nullptr;
+	if (cache && !sink && ItemsCount())	SaveCache(fName, key);
+
+	//PrintEst(file.EstItemCount());
+}
+
+/************************ end of class ReadDens ************************/
+
+/************************ class ReadCover ************************/
+
+// Adds chrom to the instance, sweeping the borders of covering regions
+//	@cID: current chrom ID
+//	@cLen: current chrom length
+void ReadCover::AddChrom(chrid cID, chrlen cLen)
+{
+	auto& starts = _borders->Starts;
+	auto& ends = _borders->Ends;
+
+	if (!is_sorted(starts.begin(), starts.end()))	sort(starts.begin(), starts.end());
+	if (!is_sorted(ends.begin(), ends.end()))		sort(ends.begin(), ends.end());
+
+	// fill items by the depth changes
+	const auto itSend = starts.end();
+	const auto itEend = ends.end();
+	auto itS = starts.begin();
+	auto itE = ends.begin();
+	chrlen prevEnd = 0;		// end of the last unzero region
+	UINT depth = 0;			// current depth of coverage
+	while (itS != itSend || itE != itEend) {
+		const chrlen pos = min(cLen, itE == itEend || (itS != itSend && *itS < *itE) ? *itS : *itE);
+		const bool wasZero = !depth;
+
+		for (; itS != itSend && min(cLen, *itS) == pos; itS++)	depth++;
+		for (; itE != itEend && min(cLen, *itE) == pos; itE++)	depth--;
+		if (depth)			AddPos(ValPos(pos, float(depth)), wasZero ? prevEnd : pos);
+		else if (!wasZero)	prevEnd = pos;
+	}
+	starts.clear();		// capacity is kept for the next chrom
+	ends.clear();
+	PlainCover::AddChrom(cID, cLen, prevEnd);
+}
+
+ReadCover::ReadCover(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval, ChromSink* sink)
+	: PlainCover(sink), _fragLen(Options::GetIVal(oFRAG_LEN))
+{
+	const BYTE dupl = BYTE(Options::GetRDuplPermit(oDUPL));
+	CacheKey key;
+	const bool cache = InitCacheKey(key, fName, cSizes, dupl);
+
+	key.ReadCov = true;
+	key.FragLen = _fragLen;
+	if (cache && LoadCache(fName, key, oinfo)) {
+		if (sink)	SinkMapped();
+		return;
+	}
+
+	RBedReader file(fName, &cSizes, dupl, oinfo, abortInval, true, !_fragLen);
+	Borders borders;
+	_borders = &borders;
+
+	if (!_fragLen) {
+		// pre-read first item to check for PE sequence
+		file.GetNextItem();
+		if (file.IsPaired())	_fIdent.reset(new FragIdent(true));	// duplicates are controlled by the reader
+	}
+	if (!sink)		// in streaming mode only one chrom is kept at once
+		ReserveItems(file.EstItemCount());
+	Pass(this, file);
+	_borders = nullptr;
+	_fIdent.reset();
+	if (cache && !sink && ItemsCount())	SaveCache(fName, key);
+}
+
+// Adds Read
+bool ReadCover::operator()()
+{
+	if (_fIdent) {				// paired-end fragment is added when both mates are read
+		Region frag;
+		if ((*_fIdent)(Read(*(RBedReader*)_file), frag))
+			AddRegion(frag.Start, frag.End);
+	}
+	else if (!_fragLen)			// the read itself
+		AddRegion(_file->ItemStart(), _file->ItemEnd());
+	else if (_file->ItemStrand())	// forward read extended downstream
+		AddRegion(_file->ItemStart(), _file->ItemStart() + _fragLen);
+	else {						// reverse read extended upstream
+		const chrlen end = _file->ItemEnd();
+		AddRegion(end > _fragLen ? end - _fragLen : 0, end);
+	}
+	return true;
+}
+
+/************************ end of class ReadCover ************************/
+
+/************************ class FeatureCover ************************/
+
+FeatureCover::FeatureCover(const Features& fs, const ChromSizes& cSizes)
+{
+	for (auto cit = fs.cBegin(); cit != fs.cEnd(); cit++) {
+		const chrid cID = CID(cit);
+		const chrlen cLen = cSizes[cID];
+		chrlen prevEnd = 0;		// end of the last unzero region
+
+		// the features cover [Start, End+1) positions, as the joint ranges of the ordinary beds do
+		for (auto it = fs.ItemsBegin(cit); it != fs.ItemsEnd(cit); it++) {
+			const chrlen end = min(chrlen(it->End + 1), cLen);
+			if (it->Start < prevEnd) {			// overlapping feature extends the region
+				if (end > prevEnd)	prevEnd = end;
+				continue;
+			}
+			AddPos(ValPos(it->Start, 1), prevEnd);	// adjacent feature is merged by AddPos
+			prevEnd = end;
+		}
+		PlainCover::AddChrom(cID, cLen, prevEnd);
+	}
+}
+
+/************************ end of class FeatureCover ************************/
+
+/************************ class StrandCC ************************/
+
+// Adds chrom to the instance
+//	@cID: current chrom ID
+//	@cLen: current chrom length
+void StrandCC::AddChrom(chrid cID, chrlen cLen)
+{
+	ChromDens cd(cID, cLen);
+
+	if (!is_sorted(_fwd.begin(), _fwd.end()))		// unsorted input
+		sort(_fwd.begin(), _fwd.end());
+	sort(_rev.begin(), _rev.end());
+	// positions beyond the chrom are not correlated
+	for (const auto& f : _fwd)
+		if (f.first < cLen) {
+			if (cd.Fwd.size() && cd.Fwd.back().first == f.first)	cd.Fwd.back().second += f.second;
+			else	cd.Fwd.push_back(f);
+		}
+	for (chrlen pos : _rev)
+		if (pos < cLen) {
+			if (cd.Rev.size() && cd.Rev.back().first == pos)	cd.Rev.back().second++;
+			else	cd.Rev.emplace_back(pos, 1);
+		}
+	_fwd.clear();		// capacity is kept for the next chrom
+	_rev.clear();
+	_chroms.push_back(move(cd));
+}
+
+// Accumulates sums of the chrom for all shifts at once
+//	@cd: chrom densities
+//	@rs: sums accumulators for each shift
+void StrandCC::CalcChrom(const ChromDens& cd, spR* rs) const
+{
+	const auto& fwd = cd.Fwd;
+	const auto& rev = cd.Rev;
+	vector<double> sumXY(_maxShift + 1, 0);
+	double sumX = 0, sumSqrX = 0, sumY = 0, sumSqrY = 0;
+
+	for (const auto& f : fwd)	sumX += f.second, sumSqrX += double(f.second) * f.second;
+	for (const auto& r : rev)	sumY += r.second, sumSqrY += double(r.second) * r.second;
+
+	// sums of products: each forward position is paired with the reverse positions within the shift range,
+	// so the whole profile is passed in a single sweep
+	auto itR0 = rev.begin();
+	for (const auto& f : fwd) {
+		while (itR0 != rev.end() && itR0->first < f.first)	itR0++;
+		for (auto itR = itR0; itR != rev.end() && itR->first - f.first <= _maxShift; itR++)
+			sumXY[itR->first - f.first] += double(f.second) * itR->second;
+	}
+
+	// sums of each signal are reduced incrementally with the shift:
+	// forward positions beyond the chrom length minus shift and reverse positions before the shift drop out
+	auto itF = fwd.rbegin();
+	auto itR = rev.begin();
+	for (chrlen d = 0; d <= _maxShift && d < cd.Len; d++) {
+		for (; itF != fwd.rend() && itF->first >= cd.Len - d; itF++)
+			sumX -= itF->second, sumSqrX -= double(itF->second) * itF->second;
+		for (; itR != rev.end() && itR->first < d; itR++)
+			sumY -= itR->second, sumSqrY -= double(itR->second) * itR->second;
+		rs[d].AddSums(cd.Len - d, sumX, sumSqrX, sumY, sumSqrY, sumXY[d]);
+	}
+}
+
+// Creates new instance by abed/bam-file name
+//	@fName: file name
+//	@cSizes: chrom sizes
+//	@maxShift: maximal shift
+//	@oinfo: verbose level
+StrandCC::StrandCC(const char* fName, ChromSizes& cSizes, chrlen maxShift, eOInfo oinfo)
+	: _maxShift(maxShift)
+{
+	RBedReader file(fName, &cSizes, BYTE(Options::GetRDuplPermit(oDUPL)), oinfo);
+
+	_file = &file;
+	file.Pass(*this);
+	_file = nullptr;
+}
+
+// Fills profile
+//	@ccs: filled coefficients for each shift
+void StrandCC::CalcProfile(vector<float>& ccs) const
+{
+	const size_t shiftCnt = size_t(_maxShift) + 1;
+	vector<spR> chromRs(_chroms.size() * shiftCnt);	// sums for each chrom and shift
+
+	Workers::Run(_chroms.size(), [&](size_t i) { CalcChrom(_chroms[i], chromRs.data() + i * shiftCnt); });
+
+	// reduce chrom sums in a fixed chrom order, so the profile does not depend on the number of threads
+	vector<spR> rs(shiftCnt);
+	for (size_t i = 0; i < _chroms.size(); i++)
+		for (size_t d = 0; d < shiftCnt; d++)
+			rs[d].Add(chromRs[i * shiftCnt + d]);
+	ccs.resize(shiftCnt);
+	for (size_t d = 0; d < shiftCnt; d++)
+		ccs[d] = rs[d].PCC();
+}
+
+// Calculates and prints profile, estimated fragment length and quality indexes
+void StrandCC::CalcR() const
+{
+	vector<float> ccs;
+	CalcProfile(ccs);
+
+	// the most frequent read length defines the 'phantom' peak
+	chrlen readLen = 0;
+	size_t maxCnt = 0;
+	for (chrlen len = 0; len < _readLens.size(); len++)
+		if (_readLens[len] > maxCnt)	readLen = len, maxCnt = _readLens[len];
+
+	float minCC = 1;
+	chrlen fragLen = 0;		// shift of the highest coefficient beyond the 'phantom' peak
+	dout << "shift\tcc\n";
+	for (chrlen d = 0; d < ccs.size(); d++) {
+		const float cc = ccs[d];
+		dout << d << TAB;
+		PrintR(cc);
+		if (cc == Undef)	continue;
+		if (cc < minCC)	minCC = cc;
+		if (d > readLen + readLen / 10 && (!fragLen || cc > ccs[fragLen]))
+			fragLen = d;
+	}
+	dout << "read length:\t" << readLen << LF;
+	if (!fragLen) {
+		dout << "fragment length is not estimated: the shift range is too short" << LF;
+		return;
+	}
+	dout << "fragment length:\t" << fragLen << LF;
+	if (minCC <= 0) {
+		dout << "quality indexes are not defined: the minimal coefficient is not positive" << LF;
+		return;
+	}
+	dout << "NSC:\t";	PrintR(ccs[fragLen] / minCC);
+	dout << "RSC:\t";
+	PrintR(ccs[readLen] == minCC || ccs[readLen] == Undef ? float(Undef) :
+		(ccs[fragLen] - minCC) / (ccs[readLen] - minCC));
+}
+
+/************************ end of class StrandCC ************************/
+
+JointedBeds::JointedBeds(const Features& fs1, const Features& fs2) : _fs1(fs1), _fs2(fs2)
+{
+	for (auto cit1 = fs1.cBegin(); cit1 != fs1.cEnd(); cit1++)
+		if (fs2.FindChrom(CID(cit1)))
+			_cIDs.push_back(CID(cit1));
+}
+
+// Merges chrom's features into the joint ranges and passes them to the callable object.
+//	@cID: chrom's ID
+//	@f: callable object with parameters (chrlen start, char val): start position and value of the next range
+template<typename F>
+void JointedBeds::MergeChrom(chrid cID, F f) const
+{
+	const Region fEnd = Region(CHRLEN_UNDEF, CHRLEN_UNDEF - 1);	// last chromosome's joint feature
+	const char VAL1 = 0x1;	// value represented first Features's feature
+	const char VAL2 = 0x2;	// value represented second Features's feature
+	const auto cit1 = _fs1.GetIter(cID);
+	const auto cit2 = _fs2.GetIter(cID);
+	const chrlen fCnt1 = chrlen(_fs1.ItemsCount(cit1));	// count of features in fs1, fs2
+	const chrlen fCnt2 = chrlen(_fs2.ItemsCount(cit2));
+	Region r1 = _fs1.Regn(cit1);
+	Region r2 = _fs2.Regn(cit2);
+	char val = 0;							// current joint range value
+
+	// loop through current chromosome's features 
+	for (chrlen fi1 = 0, fi2 = 0; fi1 < fCnt1 || fi2 < fCnt2;) {
+		chrlen pos = val & VAL1 ? (r1.End + 1) : r1.Start;
+		const chrlen pos2 = val & VAL2 ? (r2.End + 1) : r2.Start;
+
+		if (pos < pos2) {
+			val ^= VAL1;		// flip val for fs1
+			if (!(val & VAL1))	// true when fs1 feature is closed (every second range)
+				r1 = ++fi1 < fCnt1 ? _fs1.Feature(cit1, fi1) : fEnd;
+		}
+		else if (pos > pos2) {
+			pos = pos2;
+			val ^= VAL2;		// flip val for fs2
+			if (!(val & VAL2))	// true when fs2 feature is closed (every second range)
+				r2 = ++fi2 < fCnt2 ? _fs2.Feature(cit2, fi2) : fEnd;
+		}
+		else {
+			val ^= VAL1 ^ VAL2;	// flip val for both beds
+			if (!(val & VAL1))	// true when fs1 feature is closed 
+				r1 = ++fi1 < fCnt1 ? _fs1.Feature(cit1, fi1) : fEnd;
+			if (!(val & VAL2))	// true when fs2 feature is closed 
+				r2 = ++fi2 < fCnt2 ? _fs2.Feature(cit2, fi2) : fEnd;
+		}
+		f(pos, val);		// pass new joint feature
+	}
+}
+
+// 'dsR' - discrete signal Pearson coefficient (R) calculater; keeps cumulative data & calculates PCC
+class dsR : public R	// DsR
+{
+	double	_var1 = 0, _var2 = 0;	// variances 
+	double	_cov = 0;				// covariance: SUM( X-Xmean)^2 * (Y-Ymean)^2 )
+	/*
+	Mean value for every range may accept only one of two values: 0-mean or 1-mean,
+	and they are const within chromosome.
+	So for efficiency we can keep theirs in 3 arrays:
+	two square's arrays: arrays of squared values from each bed;
+	there are only 2 combinations, but they are duplicated for the simplicity acces,
+	and one crossing array: array of all combinations
+	of multiplications different values from fs1 and fs2
+	*/
+	double _sqMeans1[4], _sqMeans2[4];	// square's arrays for fs1, fs2
+	double _crossMeans[4];				// crossing array
+
+public:
+	// Keeps mean values for both features. 
+	//	@clear: if true, clear instance for treatment of new chromosome
+	void Init(const double(&mean)[2], bool clear) {
+		const double d1 = 1 - mean[0], d2 = 1 - mean[1];
+
+		_sqMeans1[0] = _sqMeans1[2] = mean[0] * mean[0];
+		_sqMeans1[1] = _sqMeans1[3] = d1 * d1;
+		_sqMeans2[0] = _sqMeans2[1] = mean[1] * mean[1];
+		_sqMeans2[2] = _sqMeans2[3] = d2 * d2;
+		_crossMeans[0] = mean[0] * mean[1];
+		_crossMeans[1] = -mean[1] * d1;
+		_crossMeans[2] = -mean[0] * d2;
+		_crossMeans[3] = d1 * d2;
+		if (clear)
+			_cov = _var1 = _var2 = 0;
+	}
+
+	// Adds accumulated data of another calculater
+	void Add(const dsR& r) { _cov += r._cov; _var1 += r._var1; _var2 += r._var2; }
+
+	// Accumulates next length of range
+	void Increment(chrlen len, char val) {
+		_cov += len * _crossMeans[val];
+		_var1 += len * _sqMeans1[val];
+		_var2 += len * _sqMeans2[val];
+	}
+
+	// Accumulates chrom's data given by the total lengths of the features and of their intersection
+	//	@mean: mean values for both features
+	//	@cSize: chrom's size
+	//	@len1: length covered by the first features
+	//	@len2: length covered by the second features
+	//	@overlap: length covered by both features
+	void Increment(const double(&mean)[2], chrlen cSize, chrlen len1, chrlen len2, chrlen overlap) {
+		_cov += overlap - mean[1] * len1 - mean[0] * len2 + cSize * mean[0] * mean[1];
+		_var1 += len1 * (1 - 2 * mean[0]) + cSize * mean[0] * mean[0];
+		_var2 += len2 * (1 - 2 * mean[1]) + cSize * mean[1] * mean[1];
+	}
+
+	// Returns Pearson coefficient of correlation
+	inline float PCC() const { return GetR(_cov, _var1, _var2); }
+};
+
+// Accumulates chrom's ranges
+//	@cID: chrom's ID
+//	@cSize: chrom's size
+//	@r: chrom accumulator
+void JointedBeds::CalcChromR(chrid cID, chrlen cSize, dsR& r) const
+{
+	const double fsLen[2]{ 
+		double(_fs1.FeaturesLength(_fs1.GetIter(cID))) / cSize,
+		double(_fs2.FeaturesLength(_fs2.GetIter(cID))) / cSize
+	};
+	chrlen start = 0;					// range's start position
+	char val = 0;						// value of current range
+
+	r.Init(fsLen, true);
+	MergeChrom(cID, [&](chrlen stop, char nextVal) {
+		r.Increment(stop - start, val);
+		// next range
+		val = nextVal;
+		start = stop;
+	});
+	r.Increment(cSize - start, 0);		// last range
+}
+
+// Prints chrom results and the total one
+//	@cIDs: treated chroms
+//	@chrRs: chrom results in the order of cIDs
+//	@returns: true if calculation was actually done
+bool JointedBeds::PrintChromRs(const vector<chrid>& cIDs, const vector<dsR>& chrRs)
+{
+	const bool isPrLocal = PrintMngr::IsPrintLocal();
+	const bool isPrTotal = PrintMngr::IsPrintTotal();
+	dsR totR;
+	bool done = false;
+
+	for (size_t i = 0; i < cIDs.size(); i++) {			// loop through chroms
+		//== print current result
+		if (isPrLocal) {
+			PrintMngr::PrintCC(chrRs[i].PCC(), cIDs[i]);
+			done = true;
+		}
+		if (isPrTotal)
+			totR.Add(chrRs[i]);
+	}
+	if (isPrTotal)
+		PrintMngr::PrintCC(totR.PCC());
+
+	return done || totR.IsDone();
+}
+
+bool JointedBeds::CalcR(const ChromSizes& cSizes) const
+{
+	vector<dsR> chrRs(_cIDs.size());
+
+	Workers::Run(_cIDs.size(), [&](size_t i) { CalcChromR(_cIDs[i], cSizes[_cIDs[i]], chrRs[i]); });
+	return PrintChromRs(_cIDs, chrRs);
+}
+
+// Calculates r without printing
+//	@cSizes: chrom sizes
+//	@cIDs: treated chroms
+//	@ccs: filled chrom coefficients in the order of cIDs (Undef for uncommon chrom), followed by the total one
+void JointedBeds::CalcR(const ChromSizes& cSizes, const vector<chrid>& cIDs, float* ccs) const
+{
+	dsR totR;
+	bool done = false;		// true if at least one chrom is treated
+
+	for (const chrid cID : cIDs) {
+		if (find(_cIDs.begin(), _cIDs.end(), cID) == _cIDs.end()) {
+			*ccs++ = Undef;
+			continue;
+		}
+		dsR chrR;
+		CalcChromR(cID, cSizes[cID], chrR);
+		*ccs++ = chrR.PCC();
+		totR.Add(chrR);
+		done = true;
+	}
+	*ccs = done ? totR.PCC() : Undef;
+}
+
+// Calculates and prints r with several compared features in a single pass through the first ones.
+// For the binary signals r is defined by the lengths of both features and of their intersection.
+// The intersection is taken from the cumulative length of the first features at the borders of the compared ones.
+// The cumulative length is built once per chrom, and each compared features are swept along it with their own index.
+//	@fs1: first valid features
+//	@fss: compared valid features
+//	@cSizes: chrom sizes
+//	@print: function called for each compared features in turn with its index
+//	and the function printing its results, which returns true if calculation was actually done
+void JointedBeds::CalcR(const Features& fs1, const vector<const Features*>& fss, const ChromSizes& cSizes,
+	const function<void(size_t, const function<bool()>&)>& print)
+{
+	// 'Unit' is the chrom treated at once with all the compared features presented in it
+	struct Unit
+	{
+		chrid	ID;
+		vector<size_t>	FsInds;		// indexes of the compared features
+		vector<dsR>		Results;	// results in the order of FsInds
+
+		Unit(chrid cID) : ID(cID) {}
+	};
+	vector<Unit> units;
+
+	for (auto cit1 = fs1.cBegin(); cit1 != fs1.cEnd(); cit1++) {
+		Unit unit(CID(cit1));
+		for (size_t i = 0; i < fss.size(); i++)
+			if (fss[i]->FindChrom(unit.ID))
+				unit.FsInds.push_back(i);
+		if (unit.FsInds.empty())	continue;
+		unit.Results.resize(unit.FsInds.size());
+		units.push_back(move(unit));
+	}
+
+	// chroms are treated independently, so they can be distributed among the threads
+	Workers::Run(units.size(), [&](size_t u) {
+		Unit& unit = units[u];
+		const auto cit1 = fs1.GetIter(unit.ID);
+		const auto it1Begin = fs1.ItemsBegin(cit1), it1End = fs1.ItemsEnd(cit1);
+		const chrlen cSize = cSizes[unit.ID];
+		vector<chrlen> cumLen(1, 0);	// cumulative length covered by the first features before each feature
+
+		// the features cover [Start, End+1) positions, as the joint ranges do
+		cumLen.reserve(it1End - it1Begin + 1);
+		for (auto it = it1Begin; it != it1End; it++)
+			cumLen.push_back(cumLen.back() + it->End + 1 - it->Start);
+
+		for (size_t i = 0; i < unit.FsInds.size(); i++) {
+			const Features& fs2 = *fss[unit.FsInds[i]];
+			const auto cit2 = fs2.GetIter(unit.ID);
+			chrlen len = 0, overlap = 0;
+			size_t ind = 0;		// number of the first features which start before the current position
+
+			// Returns the length covered by the first features before the position; the positions are increasing
+			auto covered = [&](chrlen pos) {
+				for (; ind < cumLen.size() - 1 && it1Begin[ind].Start < pos; ind++);
+				chrlen res = cumLen[ind];
+				if (ind && it1Begin[ind - 1].End + 1 > pos)
+					res -= it1Begin[ind - 1].End + 1 - pos;
+				return res;
+			};
+			for (auto it = fs2.ItemsBegin(cit2); it != fs2.ItemsEnd(cit2); it++) {
+				overlap -= covered(it->Start);
+				overlap += covered(it->End + 1);
+				len += it->End + 1 - it->Start;
+			}
+
+			const double mean[2]{
+				double(fs1.FeaturesLength(cit1)) / cSize,
+				double(fs2.FeaturesLength(cit2)) / cSize
+			};
+			dsR& r = unit.Results[i];
+
+			r.Init(mean, true);
+			r.Increment(mean, cSize, cumLen.back(), len, overlap);
+		}
+	});
+
+	// collect and print the results of each compared features in a fixed chrom order
+	for (size_t i = 0; i < fss.size(); i++) {
+		vector<chrid> cIDs;
+		vector<dsR> chrRs;
+
+		for (const auto& unit : units) {
+			const auto it = find(unit.FsInds.begin(), unit.FsInds.end(), i);
+			if (it == unit.FsInds.end())	continue;
+			cIDs.push_back(unit.ID);
+			chrRs.push_back(unit.Results[it - unit.FsInds.begin()]);
+		}
+		print(i, [&]() { return PrintChromRs(cIDs, chrRs); });
+	}
+}
+
+#ifdef _DEBUG
+void	JointedBeds::Print() const
+{
+	cout << "JointedBeds:\n";
+	for (const chrid cID : _cIDs) {
+		cout << Chrom::AbbrName(cID) << COLON;
+		MergeChrom(cID, [](chrlen start, char val) { cout << TAB << start << TAB << int(val) << LF; });
+	}
+}
+#endif
+
+/************************ end of class JointedBeds ************************/
+
+/************************ class ExtendedBeds ************************/
+
+ExtendedBeds::ExtendedBeds(const Features& fs1, const Features& fs2, const ChromSizes& cSizes, chrlen step, chrlen maxLen)
+	: _fs1(fs1), _fs2(fs2), _cSizes(cSizes), _step(step)
+{
+	// the first features are extended while they are not crossed or adjacent, like Features::Expand() does
+	chrlen minGap = CHRLEN_UNDEF;		// minimal distance between the first features
+	for (auto cit1 = fs1.cBegin(); cit1 != fs1.cEnd(); cit1++) {
+		const auto itEnd = fs1.ItemsEnd(cit1);
+		auto it = fs1.ItemsBegin(cit1);
+		if (it != itEnd)
+			for (auto itPrev = it++; it != itEnd; itPrev = it++)
+				if (it->Start - itPrev->End < minGap)
+					minGap = it->Start - itPrev->End;
+		if (fs2.FindChrom(CID(cit1)))
+			_chroms.emplace_back(CID(cit1));
+	}
+	for (chrlen ext = step; ext <= maxLen && 2 * ext < minGap; ext += step)
+		_stepCnt++;
+
+	Workers::Run(_chroms.size(), [this](size_t i) { FillChrom(_chroms[i]); });
+}
+
+// Fills chrom's lengths for each step
+//	@c: chrom's data
+void ExtendedBeds::FillChrom(ExtendedBeds::ChromExt& c) const
+{
+	const auto cit1 = _fs1.GetIter(c.ID);
+	const auto cit2 = _fs2.GetIter(c.ID);
+	const auto it2 = _fs2.ItemsBegin(cit2);
+	const size_t cnt2 = _fs2.ItemsEnd(cit2) - it2;
+	const chrlen cSize = _cSizes[c.ID];
+	const chrlen maxExt = chrlen(_stepCnt) * _step;
+	// Each length is a sum of piecewise linear functions of the extension length:
+	// their slopes are changed at the given distances from the feature ends.
+	// Distances are accumulated in the step buckets, so all the steps are filled in a single pass.
+	vector<long long> slopeAdd(_stepCnt), distAdd(_stepCnt);	// changes of the added length
+	vector<long long> slopeOvl(_stepCnt), distOvl(_stepCnt);	// changes of the overlap length
+	long long overlap = 0;			// overlap of the initial features
+	// Changes the slope of the length starting from the distance
+	auto change = [this](vector<long long>& slope, vector<long long>& dist, chrlen d, int delta) {
+		const size_t i = d / _step;		// first step on which the change is in effect
+		if (i < _stepCnt)	slope[i] += delta, dist[i] += (long long)delta * d;
+	};
+
+	c.FeatrsLen1 = _fs1.FeaturesLength(cit1);
+	c.FeatrsLen2 = _fs2.FeaturesLength(cit2);
+	for (size_t k = 0; k < cnt2; k++)
+		c.CoverLen2 += it2[k].End + 1 - it2[k].Start;
+	if (!_stepCnt)	return;
+	// The features cover [Start, End+1) positions, as the joint ranges do.
+	// Extended features are not crossed, so each fs2 feature is passed by a few fs1 features only.
+	size_t k0 = 0;		// first fs2 feature which ends after the current extended feature's start
+	for (auto it = _fs1.ItemsBegin(cit1); it != _fs1.ItemsEnd(cit1); it++) {
+		const chrlen start = it->Start, end = it->End + 1;
+		const chrlen lenL = min(start, maxExt);						// left extension limited by chrom start
+		const chrlen lenR = end < cSize ? min(cSize - end, maxExt) : 0;	// right extension limited by chrom end
+
+		c.CoverLen1 += end - start;
+		change(slopeAdd, distAdd, 0, 2);
+		change(slopeAdd, distAdd, lenL, -1);
+		change(slopeAdd, distAdd, lenR, -1);
+		for (; k0 < cnt2 && it2[k0].End + 1 <= start - lenL; k0++);
+		for (size_t k = k0; k < cnt2 && it2[k].Start < end + lenR; k++) {
+			const chrlen s2 = it2[k].Start, e2 = it2[k].End + 1;
+
+			if (s2 < start && e2 > start - lenL)		// left extension: the distance grows leftward
+				change(slopeOvl, distOvl, start - min(e2, start), 1),
+				change(slopeOvl, distOvl, start - max(s2, start - lenL), -1);
+			if (s2 < end && e2 > start)					// initial feature
+				overlap += min(e2, end) - max(s2, start);
+			if (e2 > end)								// right extension
+				change(slopeOvl, distOvl, max(s2, end) - end, 1),
+				change(slopeOvl, distOvl, min(e2, end + lenR) - end, -1);
+		}
+	}
+	c.AddLen.resize(_stepCnt);
+	c.Overlap.resize(_stepCnt);
+	for (size_t i = 0; i < _stepCnt; i++) {
+		const long long ext = (long long)(i + 1) * _step;
+		if (i) {
+			slopeAdd[i] += slopeAdd[i - 1], distAdd[i] += distAdd[i - 1];
+			slopeOvl[i] += slopeOvl[i - 1], distOvl[i] += distOvl[i - 1];
+		}
+		c.AddLen[i] = chrlen(slopeAdd[i] * ext - distAdd[i]);
+		c.Overlap[i] = chrlen(overlap + slopeOvl[i] * ext - distOvl[i]);
+	}
+}
+
+// Calculates r and prints results for each extension step
+void ExtendedBeds::CalcR() const
+{
+	const bool isPrLocal = PrintMngr::IsPrintLocal();
+	const bool isPrTotal = PrintMngr::IsPrintTotal();
+
+	for (size_t i = 0; i < _stepCnt; i++) {
+		dsR totR;
+
+		dout << "primer extended by " << chrlen(i + 1) * _step << ":\n";
+		for (const auto& c : _chroms) {
+			const chrlen cSize = _cSizes[c.ID];
+			const double mean[2]{
+				double(c.FeatrsLen1 + c.AddLen[i]) / cSize,
+				double(c.FeatrsLen2) / cSize
+			};
+			dsR chrR;
+
+			chrR.Init(mean, true);
+			chrR.Increment(mean, cSize, c.CoverLen1 + c.AddLen[i], c.CoverLen2, c.Overlap[i]);
+			if (isPrLocal)
+				PrintMngr::PrintCC(chrR.PCC(), c.ID);
+			if (isPrTotal)
+				totR.Add(chrR);
+		}
+		if (isPrTotal)
+			PrintMngr::PrintCC(totR.PCC());
+	}
+}
+
+/************************ end of class ExtendedBeds ************************/
+
+/************************ class CorrPair ************************/
+
+CorrPair::FileType CorrPair::_FileTypes[] = {
+	{ &CorrPair::CreateWig,  [](void* obj) { delete (PlainCover*)obj; }},
+	{ &CorrPair::CreateBedF, [](void* obj) { delete (Features*)obj; }},
+	{ &CorrPair::CreateBedR, [](void* obj) { delete (PlainCover*)obj; }},
+	{ &CorrPair::CreateBedFCover, [](void* obj) { delete (PlainCover*)obj; }}
+};
+
+// Creates an instance with checking primary object.
+//	@fNames: files' names, the first one is primary
+//	@cnt: number of files
+//	@rgns: genome regions
+//	@tfName: name of template bed file, or NULL if undefined
+CorrPair::CorrPair(char** fNames, short cnt, DefRegions& rgns, const char* tfName) :
+	_gRgns(rgns),
+	_typeInd(PrimaryInd(fNames, cnt))
+{
+	const char* sTemplate = "template";
+	const char* primefName = fNames[0];
+	const bool multiFiles = cnt > 2;
 
 	PrintMngr::Init(Options::GetIVal(oPR_CC), eOInfo(Options::GetIVal(oVERB)), multiFiles);
 	UniBedReader::IsTimer = PrintMngr::OutInfo() > eOInfo::LAC;
+	if (_typeInd == 3) {		// primary ordinary bed is treated as coverage
+		const bool ext = Options::GetIVal(oEXT_STEP) || (Options::GetIVal(oEXT_LEN) && !tfName);
+		Err(string("ordinary beds are compared as coverages, including the pairs of them, ")
+			+ "since the list contains coverages or alignments"
+			+ (ext ? "; their features are not extended" : "")).Warning();
+	}
 	if (tfName)
 		if (IsBedF()) {
 			if (PrintMngr::IsNotLac()) {
@@ -697,7 +2735,7 @@ CorrPair::CorrPair(const char* primefName, DefRegions& rgns, const char* tfName,
 			if (PrintMngr::IsPrName())	dout << sTemplate << SepCl;
 			_templ = new Features(FS::CheckedFileName(tfName), &_gRgns.ChrSizes(),
 				Options::GetBVal(oOVERL), PrintMngr::OutInfo(), true);
-			CheckItemsCount(_templ, tfName);
+			CheckItemsCount(_templ, tfName, _type, PrintMngr::OutInfo());
 
 			chrlen extLen = Options::GetIVal(oEXT_LEN);
 			if (extLen) {
@@ -714,7 +2752,10 @@ CorrPair::CorrPair(const char* primefName, DefRegions& rgns, const char* tfName,
 		}
 	if (PrintMngr::IsNotLac()) 	dout << "Pearson CC between\n";
 
-	_firstObj = (this->*_FileTypes[_typeInd].Create)(primefName, true);
+	_firstObj = (this->*_FileTypes[_typeInd].Create)(primefName, _type, PrintMngr::OutInfo(), true);
+	if (Options::GetSVal(oWCC) && !IsBedF())	_wccFile.open(Options::GetSVal(oWCC));
+	_stream = Options::GetBVal(oSTREAM) && !IsBedF() && !_wccFile.is_open()
+		&& !((PlainCover*)_firstObj)->Binned() && !((PlainCover*)_firstObj)->IsApprox();
 	_gRgns.Init();
 	if (PrintMngr::IsNotLac()) {
 		dout << " and";
@@ -726,86 +2767,451 @@ CorrPair::CorrPair(const char* primefName, DefRegions& rgns, const char* tfName,
 CorrPair::~CorrPair() {
 	delete _templ;
 	_FileTypes[_typeInd].Delete(_firstObj);
-	_FileTypes[_typeInd].Delete(_secondObj);
+	_FileTypes[_secondInd].Delete(_secondObj);
+}
+
+// Returns index in _FileTypes of the primary object.
+// Ordinary bed is treated as coverage if any secondary file is coverage or alignment.
+//	@fNames: files' names, including the primary one
+//	@cnt: number of files
+BYTE CorrPair::PrimaryInd(char** fNames, short cnt)
+{
+	const BYTE typeInd = CheckFileExt(fNames[0], true);
+	if (typeInd == 1)
+		for (short i = 1; i < cnt; i++)
+			switch (FT::GetType(fNames[i], Options::GetBVal(oALIGN))) {
+			case FT::eType::BGRAPH:
+			case FT::eType::ABED:
+			case FT::eType::BAM:	return 3;
+			}
+	return typeInd;
+}
+
+// Returns index in _FileTypes of the secondary object, or vUNDEF if it cannot be compared with the primary one.
+// Ordinary bed is treated as coverage if the primary object is coverage-like.
+//	@fName: secondary file's name
+char CorrPair::SecondaryInd(const char* fName)
+{
+	const char typeInd = CheckFileExt(fName, false);
+	if (typeInd == vUNDEF)	return typeInd;		// already checked
+	if (!IsBedF())	return typeInd == 1 ? 3 : typeInd;
+	if (typeInd == 1)	return typeInd;
+	Err("different" + sFormat, fName).Throw(false);
+	return vUNDEF;
+}
+
+// Calculates and prints CC between primary and current secondary objects
+//	@fName: secondary file's name
+void CorrPair::CalcCC2(const char* fName)
+{
+	bool done;
+	if (IsBedF()) {
+		if (done = CalcCCBedF(*((Features*)_firstObj)))		// 'zero extended'
+			CalcCCExt(*((Features*)_secondObj), fName);
+	}
+	else {
+		done = _secondObj ? CalcCCCover(_gRgns) : CalcCCStream(fName);
+		if (done && _wccFile.is_open())
+			((PlainCover*)_firstObj)->WriteWinR(*((PlainCover*)_secondObj), _gRgns,
+				Options::GetIVal(oWCC_LEN), Options::GetIVal(oWCC_STEP), _wccFile, fName);
+	}
+	if (!done)
+		Err("no " + FT::ItemTitle(_type) + " for common " + Chrom::Title(true)).
+			Throw(false, true);
+}
+
+// Calculates and prints CC between primary and secondary features extended step by step
+//	@second: secondary features
+//	@fName: secondary file's name
+void CorrPair::CalcCCExt(const Features& second, const char* fName)
+{
+	const int extStep = Options::GetIVal(oEXT_STEP);
+	if (!extStep)	return;
+	// calculation r by step increasing expanding length
+	const int extLen = Options::GetIVal(oEXT_LEN);
+	if (extLen < extStep)
+		Err("extending length is less then extending step. Extension has stopped here.",
+			PrintMngr::EchoName(fName)).Warning();
+	else {
+		const ExtendedBeds extBeds(*((Features*)_firstObj), second, _gRgns.ChrSizes(), extStep, extLen);
+
+		extBeds.CalcR();
+		if (extBeds.IsStopped(extLen))
+			Err("primary features are crossed by extending by " + to_string(extBeds.StopLen())
+				+ ". Extension has stopped here.", PrintMngr::EchoName(fName)).Warning();
+	}
 }
 
-// Adds secondary object, calculates and prints CCkey.
+// Adds secondary object, calculates and prints CC.
 void CorrPair::CalcCC(const char* fName)
 {
-	{	//== check type
-		char typeInd = CheckFileExt(fName, false);
-		if (typeInd != _typeInd) {
-			if (typeInd == vUNDEF)		return;		// already checked
-			return Err("different" + sFormat, fName).Throw(false);
-		}
+	const char typeInd = SecondaryInd(fName);
+	if (typeInd == vUNDEF)	return;
+	DeleteSecond();
+	if (_stream && typeInd != 3) {		// secondary object is created during calculation
+		CalcCC2(fName);
+		return;
 	}
-	_FileTypes[_typeInd].Delete(_secondObj);
-	_secondObj = nullptr;
 
 	//== create object
-	try { _secondObj = (this->*_FileTypes[_typeInd].Create)(fName, false); }
+	try { _secondObj = (this->*_FileTypes[BYTE(typeInd)].Create)(fName, _type, PrintMngr::OutInfo(), false); }
 	catch (const Err& e) { dout << e.what() << LF; return; }
+	_secondInd = typeInd;
 	
 	//== calculate r
-	bool done;
-	if (IsBedF()) {
-		if (done = CalcCCBedF(*((Features*)_firstObj))) {		// 'zero extended'
-			const int extStep = Options::GetIVal(oEXT_STEP);
-			if (extStep) {		// calculation r by step increasing expanding length
-				const int extLen = Options::GetIVal(oEXT_LEN);
-				if (extLen < extStep)
-					Err("extending length is less then extending step. Extension has stopped here.",
-						PrintMngr::EchoName(fName)).Warning();
-				else {
-					Features bedF(*((Features*)_firstObj));
-					for (int i = extStep; i <= extLen; i += extStep) {
-						dout << "primer extended by " << i << ":\n";
-						if (!bedF.Expand(extStep, &_gRgns.ChrSizes(), UniBedReader::eAction::ABORT))
-							break;
-						CalcCCBedF(bedF);
-					}
+	CalcCC2(fName);
+}
+
+// Adds secondary objects by turn, calculates and prints CC.
+// Secondaries are loaded in the background in advance, while the current pair is correlated.
+//	@fNames: secondary files' names
+//	@cnt: number of secondary files
+//	@preload: max number of secondaries loaded in advance; if 0 then they are loaded by turn
+//	@batch: max number of secondaries correlated in a single pass; if 0 then they are correlated by turn
+void CorrPair::CalcCC(char** fNames, short cnt, BYTE preload, short batch)
+{
+	if (batch && !_stream && !_wccFile.is_open()) {
+		CalcCCBatch(fNames, cnt, batch);
+		return;
+	}
+	if (!preload || _stream || !IsConcurrentLoad()) {
+		for (short i = 0; i < cnt; i++)
+			CalcCC(fNames[i]);
+		return;
+	}
+
+	// 'Loading' represents secondary object being loaded in the background
+	struct Loading {
+		const char*		FName;
+		BYTE			TypeInd;	// index in _FileTypes
+		future<void*>	Obj;
+
+		Loading(const char* fName, BYTE typeInd, future<void*>&& obj)
+			: FName(fName), TypeInd(typeInd), Obj(move(obj)) {}
+	};
+
+	deque<Loading> loads;		// secondaries are being loaded; no more then 'preload'
+	short i = 0;				// index of the next secondary to load
+
+	// Starts loading of the next valid secondaries until the limit is reached.
+	// Secondaries are loaded silently: their items are not reported.
+	auto loadNext = [&]() {
+		for (; i < cnt && loads.size() < preload; i++) {
+			const char typeInd = SecondaryInd(fNames[i]);
+			if (typeInd != vUNDEF)
+				loads.emplace_back(fNames[i], typeInd, async(launch::async,
+					_FileTypes[BYTE(typeInd)].Create, this, fNames[i], _type, eOInfo::NONE, false));
+		}
+	};
+
+	try {
+		for (loadNext(); loads.size(); ) {
+			DeleteSecond();		// release memory before the next loading
+
+			Loading& load = loads.front();
+			const char* fName = load.FName;
+			const BYTE typeInd = load.TypeInd;
+			void* obj = nullptr;
+			try { obj = load.Obj.get(); }
+			catch (const Err& e) { dout << e.what() << LF; }
+			loads.pop_front();
+			loadNext();
+			if (!obj)	continue;
+
+			_secondObj = obj;
+			_secondInd = typeInd;
+			if (PrintMngr::IsPrName())	dout << fName << LF;
+			CalcCC2(fName);
+		}
+	}
+	catch (...) {		// wait for the loading to be completed and release loaded objects
+		for (auto& load : loads)
+			try { _FileTypes[load.TypeInd].Delete(load.Obj.get()); }
+			catch (...) {}
+		throw;
+	}
+}
+
+// Adds secondary objects by batches, calculates and prints CC.
+// The batch is loaded in parallel and correlated with the primary object in a single pass,
+// so the primary object is passed once per batch instead of once per secondary.
+//	@fNames: secondary files' names
+//	@cnt: number of secondary files
+//	@batch: max number of secondaries in the batch
+void CorrPair::CalcCCBatch(char** fNames, short cnt, short batch)
+{
+	for (short i = 0; i < cnt; ) {
+		vector<const char*>		names;		// names of the secondaries being loaded
+		vector<BYTE>			inds;		// indexes in _FileTypes of the secondaries being loaded
+		vector<future<void*>>	loads;		// secondaries being loaded
+		vector<const char*>		objNames;	// names of the loaded secondaries
+		vector<BYTE>			objInds;	// indexes in _FileTypes of the loaded secondaries
+		vector<void*>			objs;		// loaded secondaries
+
+		// secondaries are loaded silently: their items are not reported.
+		// If the chrom sizes are not defined by the genome, each loading is deferred until its result is taken,
+		// so they are loaded by turn.
+		const launch policy = IsConcurrentLoad() ? launch::async : launch::deferred;
+		for (; i < cnt && loads.size() < size_t(batch); i++) {
+			const char typeInd = SecondaryInd(fNames[i]);
+			if (typeInd != vUNDEF) {
+				names.push_back(fNames[i]);
+				inds.push_back(typeInd);
+				loads.push_back(async(policy,
+					_FileTypes[BYTE(typeInd)].Create, this, fNames[i], _type, eOInfo::NONE, false));
+			}
+		}
+		try {
+			for (size_t k = 0; k < loads.size(); k++)
+				try {
+					objs.push_back(loads[k].get());
+					objNames.push_back(names[k]);
+					objInds.push_back(inds[k]);
 				}
+				catch (const Err& e) { dout << e.what() << LF; }
+
+			auto print = [&](size_t k, const function<bool()>& prResults) {
+				if (PrintMngr::IsPrName())	dout << objNames[k] << LF;
+				if (!prResults())
+					Err("no " + FT::ItemTitle(_type) + " for common " + Chrom::Title(true)).
+						Throw(false, true);
+				else if (IsBedF())
+					CalcCCExt(*((Features*)objs[k]), objNames[k]);
+			};
+			if (IsBedF()) {
+				vector<const Features*> fss;
+				for (void* obj : objs)	fss.push_back((Features*)obj);
+				JointedBeds::CalcR(*((Features*)_firstObj), fss, _gRgns.ChrSizes(), print);
+			}
+			else {
+				vector<const PlainCover*> cvs;
+				for (void* obj : objs)	cvs.push_back((PlainCover*)obj);
+				((PlainCover*)_firstObj)->CalcR(cvs, _gRgns, _templ, print);
 			}
 		}
+		catch (...) {		// wait for the loading to be completed and release loaded objects
+			for (size_t k = 0; k < loads.size(); k++)
+				if (loads[k].valid() && loads[k].wait_for(chrono::seconds(0)) != future_status::deferred)	// deferred one is not started
+					try { _FileTypes[inds[k]].Delete(loads[k].get()); }
+					catch (...) {}
+			for (size_t k = 0; k < objs.size(); k++)	_FileTypes[objInds[k]].Delete(objs[k]);
+			throw;
+		}
+		for (size_t k = 0; k < objs.size(); k++)	_FileTypes[objInds[k]].Delete(objs[k]);
 	}
-	else				
-		done = CalcCCCover(_gRgns);
-	if (!done)
-		Err("no " + FT::ItemTitle(_type) + " for common " + Chrom::Title(true)).
-			Throw(false, true);
+}
+
+// Writes matrices of coefficients for each chrom and total to the file
+//	@oName: name of the output matrix file
+//	@names: names of the compared objects
+//	@cIDs: treated chroms
+//	@ccs: coefficients of each pair of objects: chrom coefficients followed by total one
+void WriteMatrix(const char* oName, const vector<const char*>& names, const vector<chrid>& cIDs, const vector<float>& ccs)
+{
+	const size_t n = names.size();
+	const size_t stride = cIDs.size() + 1;
+	ofstream file;
+	file.open(oName);
+	// Writes matrix for the chrom or total
+	//	@k: index of coefficient in the stride
+	//	@title: matrix title
+	auto writeMatrix = [&](size_t k, const string& title) {
+		file << '#' << title << LF;
+		for (const char* name : names)	file << TAB << name;
+		file << LF;
+		for (size_t i = 0; i < n; i++) {
+			file << names[i];
+			for (size_t j = 0; j < n; j++) {
+				const float cc = ccs[(i * n + j) * stride + k];
+				file << TAB;
+				if (cc == Undef || isNaN(cc))	file << sUNDEF;
+				else	file << cc;
+			}
+			file << LF;
+		}
+	};
+	if (PrintMngr::IsPrintLocal())
+		for (size_t k = 0; k < cIDs.size(); k++)
+			writeMatrix(k, Chrom::AbbrName(cIDs[k]));
+	if (PrintMngr::IsPrintTotal())
+		writeMatrix(cIDs.size(), "total");
+	file.close();
+	if (PrintMngr::IsNotLac())
+		dout << n << 'x' << n << " matrix is written to " << oName << LF;
+}
+
+// Calculates CC between all the objects and writes them as a matrix
+//	@fNames: files' names, including the primary one
+//	@cnt: number of files
+//	@oName: name of the output matrix file
+void CorrPair::CalcMatrix(char** fNames, short cnt, const char* oName)
+{
+	const size_t tileSide = 8;		// number of objects in the tile side
+	vector<const char*> names(1, fNames[0]);	// names of the loaded objects
+	vector<void*> objs(1, _firstObj);			// loaded objects
+	vector<BYTE> objInds(1, _typeInd);			// indexes in _FileTypes of the loaded objects
+	auto release = [&]() { for (size_t i = 1; i < objs.size(); i++) _FileTypes[objInds[i]].Delete(objs[i]); };
+
+	//== load each object once.
+	// Objects are loaded in parallel, so that the decompression and parsing of the files are spread among the threads;
+	// they are loaded silently and reported by their names in the order of files.
+	// If the chrom sizes are not defined by the genome, the objects are loaded by turn.
+	vector<char>		typeInds(cnt, vUNDEF);	// indexes in _FileTypes, or vUNDEF if the file is not comparable
+	vector<FT::eType>	types(cnt);				// files' types
+	vector<void*>		loads(cnt, nullptr);	// loaded objects
+	vector<string>		errs(cnt);				// loading errors
+
+	for (short i = 1; i < cnt; i++)
+		if ((typeInds[i] = SecondaryInd(fNames[i])) != vUNDEF)
+			types[i] = _type;
+	// Loads the object following the primary one
+	//	@k: index of the object in the secondaries
+	auto load = [&](size_t k) {
+		const size_t i = k + 1;
+		if (typeInds[i] == vUNDEF)	return;
+		try { loads[i] = (this->*_FileTypes[BYTE(typeInds[i])].Create)(fNames[i], types[i], eOInfo::NONE, false); }
+		catch (const Err& e) { errs[i] = e.what(); }
+	};
+	try {
+		if (IsConcurrentLoad())	Workers::Run(cnt - 1, load);
+		else	for (short k = 0; k < cnt - 1; k++)	load(k);
+	}
+	catch (...) {
+		for (short i = 1; i < cnt; i++)
+			if (loads[i])	_FileTypes[BYTE(typeInds[i])].Delete(loads[i]);
+		throw;
+	}
+	for (short i = 1; i < cnt; i++)
+		if (loads[i]) {
+			objs.push_back(loads[i]);
+			objInds.push_back(typeInds[i]);
+			names.push_back(fNames[i]);
+			if (PrintMngr::IsPrName())	dout << fNames[i] << LF;
+		}
+		else if (errs[i].size())
+			dout << errs[i] << LF;
+
+	//== calculate the upper triangle by tiles: each tile touches no more than 2*tileSide objects
+	vector<chrid> cIDs;		// treated chroms
+	for (auto rit = _gRgns.cBegin(); rit != _gRgns.cEnd(); rit++)
+		cIDs.push_back(CID(rit));
+	const size_t n = objs.size();
+	const size_t stride = cIDs.size() + 1;			// chrom coefficients followed by total one
+	const size_t tCnt = (n + tileSide - 1) / tileSide;	// number of tiles in the side
+	vector<float> ccs(n * n * stride, 1);			// matrix of coefficients; diagonal is 1
+	vector<pair<size_t, size_t>> tiles;				// upper triangle tiles
+
+	tiles.reserve(tCnt * (tCnt + 1) / 2);
+	for (size_t ti = 0; ti < tCnt; ti++)
+		for (size_t tj = ti; tj < tCnt; tj++)
+			tiles.emplace_back(ti * tileSide, tj * tileSide);
+	try {
+		Workers::Run(tiles.size(), [&](size_t t) {
+			const size_t iEnd = min(tiles[t].first + tileSide, n);
+			const size_t jEnd = min(tiles[t].second + tileSide, n);
+
+			for (size_t i = tiles[t].first; i < iEnd; i++)
+				for (size_t j = max(tiles[t].second, i + 1); j < jEnd; j++) {
+					float* cc = &ccs[(i * n + j) * stride];
+					if (IsBedF())
+						JointedBeds(*((Features*)objs[i]), *((Features*)objs[j])).CalcR(_gRgns.ChrSizes(), cIDs, cc);
+					else
+						((PlainCover*)objs[i])->CalcR(*((PlainCover*)objs[j]), cIDs, _templ, cc);
+					copy(cc, cc + stride, &ccs[(j * n + i) * stride]);	// symmetric value
+				}
+		});
+	}
+	catch (...) { release(); throw; }
+	release();
+	WriteMatrix(oName, names, cIDs, ccs);
 }
 
 // Creates features bed object.
 //	@fName: file name
+//	@type: file type
+//	@oinfo: verbose level
 //	@primary: if true object is primary
-void* CorrPair::CreateBedF(const char* fName, bool primary)
+void* CorrPair::CreateBedF(const char* fName, FT::eType type, eOInfo oinfo, bool primary)
 {
-	Features* obj = new Features(fName, &_gRgns.ChrSizes(), Options::GetBVal(oOVERL),
-		PrintMngr::OutInfo(), primary);
-	CheckItemsCount(obj, fName);
+	Features* obj = new Features(fName, &_gRgns.ChrSizes(), Options::GetBVal(oOVERL), oinfo, primary);
+	CheckItemsCount(obj, fName, type, oinfo);
 	if (obj->NarrowLenDistr())
 		Err("looks like an alignment but is handled as ordinary bed!", PrintMngr::EchoName(fName)).Warning();
 	return obj;
 }
 
 // Creates alignment object
-void* CorrPair::CreateBedR(const char* fName, bool isPrimary)
+void* CorrPair::CreateBedR(const char* fName, FT::eType type, eOInfo oinfo, bool isPrimary)
 {
-	ReadDens* obj = new ReadDens(fName, _gRgns.ChrSizes(), PrintMngr::OutInfo(), isPrimary);
-	CheckItemsCount(obj, fName);
+	PlainCover* obj;
+	if (Options::GetBVal(oCOVER))	obj = new ReadCover(fName, _gRgns.ChrSizes(), oinfo, isPrimary);
+	else							obj = new ReadDens(fName, _gRgns.ChrSizes(), oinfo, isPrimary);
+	CheckItemsCount(obj, fName, type, oinfo);
+	CompleteCover(obj, oinfo);
 	return obj;
 }
 
 // Creates covering object.
 //	@fName: file name
+//	@type: file type
+//	@oinfo: verbose level
+//	@primary: if true object is primary
+void* CorrPair::CreateWig(const char* fName, FT::eType type, eOInfo oinfo, bool isPrimary)
+{
+	Cover* obj = new Cover(fName, _gRgns.ChrSizes(), oinfo, isPrimary);
+	CheckItemsCount(obj, fName, type, oinfo);
+	CompleteCover(obj, oinfo);
+	return obj;
+}
+
+// Creates features bed object represented as 0/1 coverage.
+//	@fName: file name
+//	@type: file type
+//	@oinfo: verbose level
 //	@primary: if true object is primary
-void* CorrPair::CreateWig(const char* fName, bool isPrimary)
+void* CorrPair::CreateBedFCover(const char* fName, FT::eType type, eOInfo oinfo, bool isPrimary)
 {
-	Cover* obj = new Cover(fName, _gRgns.ChrSizes(), PrintMngr::OutInfo(), isPrimary);
-	CheckItemsCount(obj, fName);
+	const unique_ptr<Features> fs((Features*)CreateBedF(fName, type, oinfo, isPrimary));
+	FeatureCover* obj = new FeatureCover(*fs, _gRgns.ChrSizes());
+	CompleteCover(obj, oinfo);
 	return obj;
 }
 
+// Calculates r for coverages and read densities, merging secondary cover as it is read
+//	@fName: secondary file's name
+bool CorrPair::CalcCCStream(const char* fName)
+{
+	try {
+		return ((PlainCover*)_firstObj)->CalcR([&](ChromSink& sink) {
+			const eOInfo oinfo = PrintMngr::OutInfo();
+			// object keeps nothing but the number of read items
+			auto check = [&](auto* obj) {
+				CheckItemsCount(obj, fName, _type, oinfo);
+				delete obj;
+			};
+			if (_type == FT::eType::BGRAPH)	check(new Cover(fName, _gRgns.ChrSizes(), oinfo, false, &sink));
+			else if (Options::GetBVal(oCOVER))	check(new ReadCover(fName, _gRgns.ChrSizes(), oinfo, false, &sink));
+			else							check(new ReadDens(fName, _gRgns.ChrSizes(), oinfo, false, &sink));
+		}, _gRgns, _templ);
+	}
+	catch (const Err& e) { dout << e.what() << LF; }
+	return true;	// the error is already reported
+}
+
+// Converts cover to compact or dense layout if required, and prints its memory usage
+//	@cv: created cover
+//	@oinfo: verbose level
+void CorrPair::CompleteCover(PlainCover* cv, eOInfo oinfo) const
+{
+	const int binLen = Options::GetIVal(oBIN);
+	const bool dense = !_templ && !Options::GetSVal(oWCC);	// true if the items can be replaced
+
+	if (dense && Options::Assigned(oAPPROX))	cv->Approximate(BYTE(Options::GetIVal(oAPPROX) - 1));
+	else if (dense && binLen)				cv->Bin(binLen, _gRgns.ChrSizes());
+	else if (Options::GetBVal(oCOMPACT))	cv->Pack();
+	if (oinfo == eOInfo::STAT)		cv->PrintMemUsage();
+}
+
 // Checks file extisting and extention validity
 //	@fName: file's name
 //	@abortInvalid: if true throw extention if checking is false
@@ -825,3 +3231,325 @@ char CorrPair::CheckFileExt(const char* fName, bool abortInvalid)
 }
 
 /************************ end of class CorrPair ************************/
+
+/************************ class BinStore ************************/
+
+// 'StoreHeader' is the header of the store file.
+// It is followed by the values of non-uniform chunks of all columns, by the column table,
+// by the chunk table and by the zero-terminated names of the samples.
+struct StoreHeader
+{
+	char	Sign[8];		// file signature
+	UINT	Version;		// format version
+	UINT	SampleCnt;		// number of samples
+	chrlen	BinLen;			// length of bin
+	UINT	ChunkLen;		// number of bins in the chunk
+	size_t	ColCnt;			// number of columns
+	size_t	ChunkCnt;		// number of chunks
+	size_t	TablesOffset;	// offset of the column table
+	size_t	NamesSize;		// size of the samples' names
+};
+
+static const char StoreSign[8] = { 'b','i','o','C','C','s','t','\0' };
+static const UINT StoreVersion = 1;
+static const char* StoreExt = ".bcs";
+
+// Creates cover of the sample
+//	@fName: sample file name
+//	@cSizes: chrom sizes
+//	return: cover, or NULL if the file has unpredictable format
+PlainCover* CreateCover(const char* fName, ChromSizes& cSizes)
+{
+	switch (FT::GetType(fName, Options::GetBVal(oALIGN))) {
+	case FT::eType::BGRAPH:	return new Cover(fName, cSizes, eOInfo::NONE, false);
+	case FT::eType::ABED:
+	case FT::eType::BAM:
+		if (Options::GetBVal(oCOVER))	return new ReadCover(fName, cSizes, eOInfo::NONE, false);
+		return new ReadDens(fName, cSizes, eOInfo::NONE, false);
+	case FT::eType::BED: {
+		const Features fs(fName, &cSizes, Options::GetBVal(oOVERL), eOInfo::NONE, false);
+		return new FeatureCover(fs, cSizes);
+	}
+	}
+	return nullptr;
+}
+
+// Returns true if file is a store
+//	@fName: file name
+bool BinStore::IsStore(const char* fName)
+{
+	const size_t len = strlen(fName), extLen = strlen(StoreExt);
+	return len > extLen && !strcmp(fName + len - extLen, StoreExt);
+}
+
+// Creates store of the covers binned by the length given by --bin option.
+// Samples are loaded and binned in parallel by the groups of the threads number.
+//	@fNames: input files' names
+//	@cnt: number of input files
+//	@cSizes: chrom sizes
+//	@sName: store file name
+void BinStore::Build(char** fNames, short cnt, ChromSizes& cSizes, const char* sName)
+{
+	const chrlen binLen = Options::GetIVal(oBIN);
+	if (!binLen)
+		Err(Options::OptionToStr(oBIN) + " is required to build the store", sName).Throw();
+
+	const string tmpName = string(sName) + ".tmp";	// the store file appears only when it is complete
+	ofstream file(tmpName, ios::binary);
+	StoreHeader head;
+	vector<Column> cols;
+	vector<Chunk> chunks;
+	vector<const char*> names;		// names of the stored samples
+
+	if (!file)	Err("cannot be written", sName).Throw();
+	memset(&head, 0, sizeof(head));
+	file.write((const char*)&head, sizeof(head));	// placeholder
+
+	for (short i = 0; i < cnt; i += Workers::Count()) {
+		const size_t grpCnt = min<size_t>(Workers::Count(), cnt - i);
+		vector<unique_ptr<PlainCover::BinnedItems>> bins(grpCnt);
+		vector<string> errs(grpCnt);	// errors are reported in the order of samples
+		vector<char> absent(grpCnt);
+
+		for (size_t k = 0; k < grpCnt; k++)
+			absent[k] = FS::CheckFileExist(fNames[i + k], false);
+		// the group of samples is kept in memory in dense layout only
+		Workers::Run(grpCnt, [&](size_t k) {
+			const char* fName = fNames[i + k];
+			if (absent[k])	return;
+			try {
+				unique_ptr<PlainCover> cv(CreateCover(fName, cSizes));
+				if (!cv)	errs[k] = Err("unpredictable" + sFormat, fName).what();
+				else if (!cv->ItemsCount())	errs[k] = Err("no items", fName).what();
+				else	bins[k].reset(new PlainCover::BinnedItems(*cv, binLen, cSizes));
+			}
+			catch (const Err& e) { errs[k] = e.what(); }
+		});
+		// each chrom of the sample is written as a column
+		for (size_t k = 0; k < grpCnt; k++) {
+			if (!bins[k]) {
+				if (errs[k].size())	dout << errs[k] << LF;
+				continue;
+			}
+			for (const auto& c : bins[k]->Chroms()) {
+				const vector<float>& vals = c.second;
+				if (vals.empty())	continue;
+				cols.push_back({ chunks.size(), UINT(names.size()), UINT(vals.size()), c.first });
+				for (size_t first = 0; first < vals.size(); first += ChunkLen) {
+					const float* v = vals.data() + first;
+					const size_t len = min<size_t>(ChunkLen, vals.size() - first);
+					Chunk ch{ 0, 0, 0, v[0] };
+					bool uniform = true;
+
+					for (size_t j = 0; j < len; j++) {
+						ch.Sum += v[j];
+						ch.SumSqr += double(v[j]) * v[j];
+						uniform &= v[j] == ch.Val;
+					}
+					if (!uniform) {
+						ch.Offset = size_t(file.tellp());
+						file.write((const char*)v, len * sizeof(float));
+					}
+					chunks.push_back(ch);
+				}
+			}
+			names.push_back(fNames[i + k]);
+			if (eOInfo(Options::GetIVal(oVERB)) > eOInfo::LAC)	dout << fNames[i + k] << LF;
+		}
+	}
+
+	//== tables
+	memcpy(head.Sign, StoreSign, sizeof(StoreSign));
+	head.Version = StoreVersion;
+	head.SampleCnt = UINT(names.size());
+	head.BinLen = binLen;
+	head.ChunkLen = ChunkLen;
+	head.ColCnt = cols.size();
+	head.ChunkCnt = chunks.size();
+	for (size_t pos = size_t(file.tellp()); pos % alignof(Chunk); pos++)
+		file.put(0);
+	head.TablesOffset = size_t(file.tellp());
+	file.write((const char*)cols.data(), cols.size() * sizeof(Column));
+	file.write((const char*)chunks.data(), chunks.size() * sizeof(Chunk));
+	for (const char* name : names) {
+		const size_t len = strlen(name) + 1;
+		file.write(name, len);
+		head.NamesSize += len;
+	}
+	file.seekp(0);
+	file.write((const char*)&head, sizeof(head));
+	file.close();
+	if (!file || (remove(sName), rename(tmpName.c_str(), sName))) {
+		remove(tmpName.c_str());
+		Err("cannot be written", sName).Throw();
+	}
+	if (eOInfo(Options::GetIVal(oVERB)) > eOInfo::LAC)
+		dout << names.size() << " samples are written to " << sName << LF;
+}
+
+// Maps existing store into memory
+//	@fName: store file name
+BinStore::BinStore(const char* fName) : _file(new MappedFile(FS::CheckedFileName(fName)))
+{
+	if (!_file->IsValid() || _file->Size() < sizeof(StoreHeader))
+		Err("is not a valid store", fName).Throw();
+	const StoreHeader& head = *(const StoreHeader*)_file->Data();
+	if (memcmp(head.Sign, StoreSign, sizeof(StoreSign)) || head.Version != StoreVersion
+	|| head.ChunkLen != ChunkLen
+	|| _file->Size() != head.TablesOffset + head.ColCnt * sizeof(Column) + head.ChunkCnt * sizeof(Chunk) + head.NamesSize)
+		Err("is not a valid store", fName).Throw();
+
+	const Column* cols = (const Column*)(_file->Data() + head.TablesOffset);
+	const char* name = (const char*)(cols + head.ColCnt) + head.ChunkCnt * sizeof(Chunk);
+
+	_binLen = head.BinLen;
+	_chunks = (const Chunk*)(cols + head.ColCnt);
+	for (UINT i = 0; i < head.SampleCnt; i++, name += strlen(name) + 1)
+		_samples.push_back(name);
+	for (size_t i = 0; i < head.ColCnt; i++) {
+		vector<const Column*>& chrCols = _chroms[cols[i].ID];
+		chrCols.resize(head.SampleCnt, nullptr);
+		chrCols[cols[i].Sample] = cols + i;
+	}
+}
+
+// Accumulates sums of two columns within the chrom.
+// Uniform chunks are not scanned: their sums are taken from the chunk table,
+// and the sum of products is the value of the uniform chunk multiplied by the sum of the other one.
+//	@colX: first column
+//	@colY: second column
+//	@chrR: chrom sums accumulator
+void BinStore::CalcChromR(const Column& colX, const Column& colY, spR& chrR) const
+{
+	const UINT cnt = min(colX.BinCnt, colY.BinCnt);
+	double sumX = 0, sumY = 0, sumSqrX = 0, sumSqrY = 0, sumXY = 0;
+	genlen uniLen = 0;		// number of bins in the chunks treated by the sums
+
+	for (UINT first = 0, k = 0; first < cnt; first += ChunkLen, k++) {
+		const Chunk& chX = _chunks[colX.FirstChunk + k];
+		const Chunk& chY = _chunks[colY.FirstChunk + k];
+		const UINT len = min(ChunkLen, cnt - first);
+		const float* x = Values(chX);
+		const float* y = Values(chY);
+
+		if (x && y) {			// both chunks keep values
+			AddBinSums(x, y, len, chrR);
+			continue;
+		}
+		uniLen += len;
+		if (len == min(ChunkLen, colX.BinCnt - first) && len == min(ChunkLen, colY.BinCnt - first)) {
+			sumX += chX.Sum;	sumSqrX += chX.SumSqr;
+			sumY += chY.Sum;	sumSqrY += chY.SumSqr;
+			sumXY += x ? chX.Sum * chY.Val : chX.Val * chY.Sum;
+		}
+		else				// the last chunk of the longer column is truncated
+			for (UINT i = 0; i < len; i++) {
+				const double vx = x ? x[i] : chX.Val, vy = y ? y[i] : chY.Val;
+				sumX += vx;		sumSqrX += vx * vx;
+				sumY += vy;		sumSqrY += vy * vy;
+				sumXY += vx * vy;
+			}
+	}
+	chrR.AddSums(uniLen, sumX, sumSqrX, sumY, sumSqrY, sumXY);
+}
+
+// Fills the coefficients of two samples for each chrom followed by the total one
+//	@x: first sample index
+//	@y: second sample index
+//	@cIDs: treated chroms
+//	@ccs: coefficients; Undef if the chrom is absent in any sample
+//	return: true if at least one chrom is treated
+bool BinStore::CalcR(UINT x, UINT y, const vector<chrid>& cIDs, float* ccs) const
+{
+	spR totR;
+	bool done = false;		// true if at least one chrom is treated
+
+	for (const chrid cID : cIDs) {
+		const vector<const Column*>& chrCols = _chroms.at(cID);
+		if (!chrCols[x] || !chrCols[y]) {
+			*ccs++ = Undef;
+			continue;
+		}
+		spR chrR;
+		CalcChromR(*chrCols[x], *chrCols[y], chrR);
+		*ccs++ = chrR.PCC();
+		totR.Add(chrR);
+		done = true;
+	}
+	*ccs = done ? totR.PCC() : Undef;
+	return done;
+}
+
+// Calculates and prints CC between the first selected sample and the others,
+// or between all of them written as a matrix
+//	@samples: comma-separated names of the selected samples, or NULL if all the samples are selected
+//	@oName: name of the output matrix file, or NULL if matrix is not required
+void BinStore::CalcR(const char* samples, const char* oName) const
+{
+	vector<UINT> inds;		// indexes of the selected samples
+	if (samples) {
+		const string list(samples);
+		for (size_t pos = 0, end; pos <= list.size(); pos = end + 1) {
+			end = list.find(',', pos);
+			if (end == string::npos)	end = list.size();
+			const string name = list.substr(pos, end - pos);
+			auto it = find_if(_samples.begin(), _samples.end(), [&](const char* s) { return name == s; });
+			if (it == _samples.end())	Err("is absent in the store", name.c_str()).Throw(false);
+			else	inds.push_back(UINT(it - _samples.begin()));
+		}
+	}
+	else
+		for (UINT i = 0; i < _samples.size(); i++)	inds.push_back(i);
+	if (inds.size() < 2)
+		Err(Err::MISSED, NULL, "secondary samples").Throw();
+
+	vector<chrid> cIDs;		// treated chroms
+	for (const auto& c : _chroms)
+		if (!Chrom::IsSetByUser() || c.first == Chrom::UserCID())
+			cIDs.push_back(c.first);
+	const size_t n = inds.size();
+	const size_t stride = cIDs.size() + 1;			// chrom coefficients followed by total one
+
+	PrintMngr::Init(Options::GetIVal(oPR_CC), eOInfo(Options::GetIVal(oVERB)), n > 2);
+	if (oName) {
+		vector<float> ccs(n * n * stride, 1);		// matrix of coefficients; diagonal is 1
+		vector<pair<size_t, size_t>> pairs;			// upper triangle
+		vector<const char*> names;
+
+		for (size_t i = 0; i < n; i++) {
+			names.push_back(_samples[inds[i]]);
+			for (size_t j = i + 1; j < n; j++)	pairs.emplace_back(i, j);
+		}
+		// columns are mapped, so any pair can be treated independently
+		Workers::Run(pairs.size(), [&](size_t p) {
+			const size_t i = pairs[p].first, j = pairs[p].second;
+			float* cc = &ccs[(i * n + j) * stride];
+			CalcR(inds[i], inds[j], cIDs, cc);
+			copy(cc, cc + stride, &ccs[(j * n + i) * stride]);	// symmetric value
+		});
+		WriteMatrix(oName, names, cIDs, ccs);
+		return;
+	}
+
+	vector<float> ccs((n - 1) * stride);	// coefficients of each secondary sample
+	vector<char> done(n - 1);				// true if at least one chrom is treated for secondary sample
+
+	Workers::Run(n - 1, [&](size_t k) { done[k] = CalcR(inds[0], inds[k + 1], cIDs, &ccs[k * stride]); });
+	if (PrintMngr::IsNotLac())
+		dout << "Pearson CC between\n" << _samples[inds[0]] << "\n and" << (n > 2 ? "..." : "") << LF;
+	for (size_t k = 0; k < n - 1; k++) {
+		const float* cc = &ccs[k * stride];
+		if (PrintMngr::IsPrName())	dout << _samples[inds[k + 1]] << LF;
+		if (!done[k]) {
+			Err("no common " + Chrom::Title(true)).Throw(false, true);
+			continue;
+		}
+		if (PrintMngr::IsPrintLocal())
+			for (size_t i = 0; i < cIDs.size(); i++)
+				if (cc[i] != Undef)	PrintMngr::PrintCC(cc[i], cIDs[i]);
+		if (PrintMngr::IsPrintTotal())
+			PrintMngr::PrintCC(cc[cIDs.size()]);
+	}
+}
+
+/************************ end of class BinStore ************************/
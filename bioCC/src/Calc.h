@@ -2,7 +2,7 @@
 Calc.h
 Provides classes for calculating CC
 2014 Fedor Naumenko (fedor.naumenko@gmail.com)
-Last modified: 07/28/2024
+Last modified: 10/16/2026
 ***********************************************************/
 #pragma once
 
@@ -10,8 +10,15 @@ Last modified: 07/28/2024
 #include "Options.h"
 #include "DefRegions.h"
 #include "Features.h"
+#include "Cache.h"
+#include <functional>
+#include <algorithm>
 
 
+class dsR;		// discrete signal Pearson coefficient calculater
+class spR;		// single-pass Pearson coefficient calculater
+struct ChromR;	// chrom results of the cover Pearson coefficient
+
 typedef pair<double, double> pairDbl;
 typedef pair<Regions::Iter, Regions::Iter> RegionsRange;
 
@@ -61,7 +68,8 @@ public:
 	// Prints PCC
 	//	@cc: correlation coefficient
 	//	@cID: calculated chrom pcc or total
-	static void PrintCC(float cc, chrid cID = Chrom::UnID);
+	//	@dev: bound of the coefficient deviation, or negative if coefficient is exact
+	static void PrintCC(float cc, chrid cID = Chrom::UnID, float dev = -1);
 
 private:
 	static ePrint	_PrintCC;
@@ -93,23 +101,263 @@ struct ValPos
 #endif	// _DEBUG
 };
 
-// 'PlainCover' represents coverage as a collection of ValPos. Base class for Cover and ReadDens
+// 'ChromSink' receives chrom's items of the cover as soon as the chrom is read
+class ChromSink
+{
+public:
+	// Treats chrom's items
+	//	@cID: chrom
+	//	@items: items buffer; can be taken over by the sink
+	//	@first: index of the first chrom's item in the buffer; the chrom's items last up to the end of the buffer
+	virtual void operator()(chrid cID, vector<ValPos>&& items, size_t first) = 0;
+};
+
+// 'PlainCover' represents coverage as a collection of ValPos. Base class for Cover, ReadDens and ReadCover
 class PlainCover : public Items<ValPos>
 {
 	// PlainCover is represented by a set of ALL valued ranges, including zero valued.
 	// Thus regions span the entire chromosome space.
 	// Zero valued ranges are not represented in input WIG file, they are added during initialization.
 
+public:
+	// 'PackedItems' keeps items in compact layout: positions are delta-encoded in blocks,
+	// values are dictionary-coded if the number of distinct values does not exceed 2^16
+	class PackedItems
+	{
+	public:
+		static const BYTE BlockLen = 64;	// number of items in the block
+
+	private:
+		// 'Block' keeps the first position of the block and the offset of its deltas
+		struct Block {
+			chrlen	Pos;		// position of the first item
+			size_t	Offset;		// offset of the next position delta in _deltas
+		};
+
+		vector<Block>	_blocks;
+		vector<BYTE>	_deltas;	// LEB128-encoded differences between adjacent positions
+		vector<USHORT>	_codes;		// dictionary codes of values; empty if values are not dictionary-coded
+		vector<float>	_dict;		// dictionary of values
+		vector<float>	_vals;		// values if they are not dictionary-coded
+		map<chrid, pair<size_t, size_t>> _chroms;	// first and after the last item indexes for each chrom
+		size_t			_count;		// number of items
+
+	public:
+		// Creates compact representation of cover items
+		PackedItems(const PlainCover& cv);
+
+		// Returns first and after the last item indexes of the chrom
+		const pair<size_t, size_t>& Range(chrid cID) const { return _chroms.at(cID); }
+
+		// Returns number of items
+		size_t Count() const { return _count; }
+
+		// Returns position of the first item of the block
+		//	@bInd: block index
+		chrlen BlockPos(size_t bInd) const { return _blocks[bInd].Pos; }
+
+		// Decodes block
+		//	@bInd: block index
+		//	@buf: decoded items
+		void Decode(size_t bInd, ValPos* buf) const;
+
+		// Returns true if values are dictionary-coded
+		bool IsDictCoded() const { return _dict.size(); }
+
+		// Returns occupied memory in bytes
+		size_t MemSize() const;
+	};
+
+	// 'PlainCursor' sequentially reads chrom's items in plain or mapped layout
+	class PlainCursor
+	{
+		const ValPos*	_it;
+		const ValPos*	_end;
+	public:
+		PlainCursor(const PlainCover& cv, chrid cID) {
+			const ItemIndices& data = cv.GetIter(cID)->second.Data;
+			_it = cv.ItemsData() + data.FirstInd;
+			_end = cv.ItemsData() + data.LastInd;
+		}
+
+		PlainCursor(const ValPos* first, const ValPos* last) : _it(first), _end(last) {}
+
+		bool IsEnd() const { return _it == _end; }
+
+		const ValPos& operator*() const { return *_it; }
+
+		const ValPos* operator->() const { return &*_it; }
+
+		PlainCursor& operator++() { ++_it; return *this; }
+
+		// Moves to the first item with position not less than the given one, galloping from the current item
+		//	@pos: position
+		//	@val: value of the last passed item; is not changed if no item is passed
+		void SeekTo(chrlen pos, float& val) {
+			if (_it == _end || _it->Pos >= pos)	return;
+			size_t step = 1;
+			const ValPos* it = _it;		// the last item before pos
+			for (; step < size_t(_end - it) && it[step].Pos < pos; step <<= 1)
+				it += step;
+			_it = lower_bound(it + 1, it + min(step, size_t(_end - it)), pos,
+				[](const ValPos& vp, chrlen p) { return vp.Pos < p; });
+			val = _it[-1].Val;
+		}
+	};
+
+	// 'PackedCursor' sequentially reads chrom's items in compact layout, decoding them block by block
+	class PackedCursor
+	{
+		const PackedItems& _pack;
+		size_t	_ind;			// index of the current item
+		size_t	_end;			// index of the item after the last one
+		BYTE	_bInd = 0;		// index of the current item in the buffer
+		ValPos	_buf[PackedItems::BlockLen];	// decoded block
+	public:
+		PackedCursor(const PlainCover& cv, chrid cID);
+
+		bool IsEnd() const { return _ind >= _end; }
+
+		const ValPos& operator*() const { return _buf[_bInd]; }
+
+		const ValPos* operator->() const { return _buf + _bInd; }
+
+		PackedCursor& operator++() {
+			if (++_ind < _end && ++_bInd == PackedItems::BlockLen) {
+				_pack.Decode(_ind / PackedItems::BlockLen, _buf);
+				_bInd = 0;
+			}
+			return *this;
+		}
+
+		// Moves to the first item with position not less than the given one, using blocks directory
+		//	@pos: position
+		//	@val: value of the last passed item; is not changed if no item is passed
+		void SeekTo(chrlen pos, float& val);
+	};
+
+	// 'BinnedItems' keeps cover in dense layout: the mean value for each bin of fixed length
+	class BinnedItems
+	{
+		const chrlen	_binLen;	// length of bin
+		map<chrid, vector<float>>	_chroms;	// bins for each chrom
+
+	public:
+		// Creates dense representation of cover items
+		//	@cv: cover
+		//	@binLen: length of bin
+		//	@cSizes: chrom sizes
+		BinnedItems(const PlainCover& cv, chrlen binLen, const ChromSizes& cSizes);
+
+		// Returns length of bin
+		chrlen BinLen() const { return _binLen; }
+
+		// Returns bins of the chrom
+		const vector<float>& Bins(chrid cID) const { return _chroms.at(cID); }
+
+		// Returns bins of all chroms
+		const map<chrid, vector<float>>& Chroms() const { return _chroms; }
+
+		// Returns number of bins
+		size_t Count() const;
+	};
+
+	// 'Pyramid' keeps the sums of cover values and of their squares within the windows
+	// of several fixed lengths, to calculate approximate coefficients quickly
+	class Pyramid
+	{
+	public:
+		static const BYTE LevelCnt = 3;		// number of levels
+		static const chrlen WinLens[LevelCnt];	// lengths of windows on each level
+
+		// 'WinSums' keeps the sums of one window
+		struct WinSums
+		{
+			double	Sum;		// sum of the values
+			double	SumSqr;		// sum of the squared values
+		};
+
+	private:
+		// 'ChromWins' is the chrom's windows of all levels in succession
+		struct ChromWins
+		{
+			chrlen	Length;			// length of chrom covered by windows
+			const WinSums* Data;	// windows
+		};
+		vector<WinSums>	_data;		// windows built by the instance; empty if they are mapped
+		map<chrid, ChromWins>	_chroms;
+
+	public:
+		// Returns number of windows of the chrom on the level
+		//	@len: chrom length
+		//	@level: level
+		static size_t WinCount(chrlen len, BYTE level) { return (size_t(len) + WinLens[level] - 1) / WinLens[level]; }
+
+		// Returns number of windows of the chrom on all levels
+		//	@len: chrom length
+		static size_t WinCount(chrlen len);
+
+		// Creates empty instance to be filled by mapped windows
+		Pyramid() {}
+
+		// Creates pyramid of cover items
+		//	@cv: cover
+		Pyramid(const PlainCover& cv);
+
+		// Adds chrom's windows kept outside
+		//	@cID: chrom
+		//	@len: chrom length
+		//	@data: windows of all levels in succession
+		void AddChrom(chrid cID, chrlen len, const WinSums* data) { _chroms[cID] = { len, data }; }
+
+		// Returns length of chrom covered by windows, or 0 if chrom is absent
+		chrlen Length(chrid cID) const {
+			const auto it = _chroms.find(cID);
+			return it == _chroms.end() ? 0 : it->second.Length;
+		}
+
+		// Returns chrom's windows on the level
+		//	@cID: chrom
+		//	@level: level
+		const WinSums* Windows(chrid cID, BYTE level) const;
+
+		// Returns number of windows on all levels
+		size_t Count() const;
+	};
+
+private:
 	const float _binWidth;		// width of bins of histogram; if 0, no histogram
 	const eRS	 _printFRes;	// sign to print results for each feature from 'template' and how to sort it
+	unique_ptr<PackedItems> _packed;	// items in compact layout, or NULL if they are in plain layout
+	unique_ptr<BinnedItems> _binned;	// items in dense layout, or NULL
+	unique_ptr<Pyramid>		_pyramid;	// sums over the windows, or NULL
+	BYTE	_approx = 0;		// level of the pyramid by which coefficients are approximated, plus 1; 0 if they are exact
+	unique_ptr<MappedFile>	_mapped;	// cache file keeping items in mapped layout, or NULL
+	const ValPos*	_mappedItems = nullptr;	// items in mapped layout
+	size_t			_mappedCnt = 0;			// number of items in mapped layout
+
+	// Returns items in plain or mapped layout
+	const ValPos* ItemsData() const { return _mapped ? _mappedItems : _items.data(); }
+
+	// Prints chrom results and reduces them to the total one
+	//	@cIDs: treated chroms
+	//	@chrRs: chrom results in the order of cIDs
+	//	@templ: template to define treated regions
+	//	return: true if calculation was actually done
+	bool PrintChromRs(const vector<chrid>& cIDs, vector<ChromR>& chrRs, const Features* templ);
 
 protected:
 	UniBedReader* _file = nullptr;	// for child constructor only
 	size_t	_lastInd = 0;			// last index of recorded item; for child constructor only
+	ChromSink* const _sink;			// receiver of the read chroms in streaming mode, or NULL
+	size_t	_sunkCnt = 0;			// number of items passed to the sink
 
-	PlainCover() :
+	// Creates empty instance
+	//	@sink: receiver of the read chroms; if set, chrom's items are released as soon as they are passed to it
+	PlainCover(ChromSink* sink = nullptr) :
 		_binWidth(Options::GetFVal(oBIN_WIDTH)),
-		_printFRes(Options::Assigned(oPR_FCC) ? eRS(Options::GetIVal(oPR_FCC)) : eRS::rsOFF)
+		_printFRes(Options::Assigned(oPR_FCC) ? eRS(Options::GetIVal(oPR_FCC)) : eRS::rsOFF),
+		_sink(sink)
 	{}
 
 	// pass through file records
@@ -137,7 +385,47 @@ protected:
 	//	@prevEnd: end of previous entry
 	void AddChrom(chrlen cID, chrlen cLen, chrlen prevEnd);
 
+	// Initializes cache key if caching is required
+	//	@key: initialized key
+	//	@fName: source file name
+	//	@cSizes: chrom sizes
+	//	@dupl: duplicates permission, or 0 if not applicable
+	//	return: true if caching is required and possible
+	static bool InitCacheKey(CacheKey& key, const char* fName, const ChromSizes& cSizes, BYTE dupl);
+
+	// Initializes instance from the cache file in mapped layout
+	//	@fName: source file name
+	//	@key: source file key
+	//	@oinfo: verbose level
+	//	return: true if cache file exists and matches the key
+	bool LoadCache(const char* fName, const CacheKey& key, eOInfo oinfo);
+
+	// Saves items and their pyramid to the cache file, building the pyramid if it is absent
+	//	@fName: source file name
+	//	@key: source file key
+	void SaveCache(const char* fName, const CacheKey& key);
+
+	// Calculates chrom results on the threads
+	//	@cv: compared cover
+	//	@cIDs: chroms presented in both covers
+	//	@templ: template to define treated regions; ignored for the approximated or dense layout
+	//	@fillLocRes: true if coefficients of the template features should be filled
+	//	@chrRs: filled chrom results in the order of cIDs
+	void FillChromRs(const PlainCover& cv, const vector<chrid>& cIDs, const Features* templ,
+		bool fillLocRes, vector<ChromR>& chrRs) const;
+
+	// Passes items in mapped layout to the sink chrom by chrom
+	void SinkMapped();
+
 public:
+	using Items<ValPos>::ItemsCount;
+
+	virtual ~PlainCover() {}
+
+	// Returns number of items regardless of layout
+	size_t ItemsCount() const
+	{ return _packed ? _packed->Count() : _mapped ? _mappedCnt : _sink ? _sunkCnt : _items.size(); }
+
 	// Calculates and prints corr. coefficients, using single-pass range-based algorithm
 	//	@cv: compared cover
 	//	@gRgns: def regions (chrom sizes)
@@ -145,6 +433,65 @@ public:
 	//	return: true if calculation was actually done
 	bool CalcR(const PlainCover& cv, const DefRegions& gRgns, const Features* templ);
 
+	// Calculates and prints corr. coefficients with the cover which is not kept in memory:
+	// its chroms are merged with this cover as soon as they are read
+	//	@read: function reading compared cover chroms into the given sink
+	//	@gRgns: def regions (chrom sizes)
+	//	@templ: template to define treated regions
+	//	return: true if calculation was actually done
+	bool CalcR(const function<void(ChromSink&)>& read, const DefRegions& gRgns, const Features* templ);
+
+	// Calculates and prints corr. coefficients with several compared covers in a single pass through this cover
+	//	@cvs: compared covers
+	//	@gRgns: def regions (chrom sizes)
+	//	@templ: template to define treated regions
+	//	@print: function called for each compared cover in turn with its index
+	//	and the function printing its results, which returns true if calculation was actually done
+	void CalcR(const vector<const PlainCover*>& cvs, const DefRegions& gRgns, const Features* templ,
+		const function<void(size_t, const function<bool()>&)>& print);
+
+	// Calculates corr. coefficients without printing
+	//	@cv: compared cover
+	//	@cIDs: treated chroms
+	//	@templ: template to define treated regions
+	//	@ccs: filled chrom coefficients in the order of cIDs (Undef for uncommon chrom), followed by the total one
+	void CalcR(const PlainCover& cv, const vector<chrid>& cIDs, const Features* templ, float* ccs) const;
+
+	// Returns true if items are in compact layout
+	bool IsPacked() const { return bool(_packed); }
+
+	// Converts items to compact layout and releases the plain ones; items in mapped layout remain as they are
+	void Pack();
+
+	// Returns items in dense layout, or NULL
+	const BinnedItems* Binned() const { return _binned.get(); }
+
+	// Converts items to dense layout and releases the items in any other layout
+	//	@binLen: length of bin
+	//	@cSizes: chrom sizes
+	void Bin(chrlen binLen, const ChromSizes& cSizes);
+
+	// Returns true if coefficients are approximated by the pyramid
+	bool IsApprox() const { return _approx; }
+
+	// Forces coefficients to be approximated by the pyramid, building it if it is absent
+	//	@level: level of the pyramid
+	void Approximate(BYTE level);
+
+	// Calculates coefficients in sliding windows and writes them as bedGraph track.
+	// Each window is represented by its central part of the step length.
+	//	@cv: compared cover
+	//	@gRgns: def regions (chrom sizes)
+	//	@winLen: length of window
+	//	@step: step of window
+	//	@file: output file
+	//	@name: track name
+	void WriteWinR(const PlainCover& cv, const DefRegions& gRgns,
+		chrlen winLen, chrlen step, ofstream& file, const char* name) const;
+
+	// Prints memory occupied by one interval
+	void PrintMemUsage() const;
+
 	// Writes inner representation to BEDGRAPG file
 	void Write(const string& fName) const;
 };
@@ -162,8 +509,12 @@ class Cover : public PlainCover
 	void AddChrom(chrlen cID, chrlen cLen) { PlainCover::AddChrom(cID, cLen, _file->PrevItemEnd()); }
 
 	// Initializes instance from wig file
+	//	@fixedStep: true for fixedStep format, false for variableStep one
+	//	@fName: file name for the error message
+	//	@oinfo: verbose level
 	//	return: numbers of all and initialied items for given chrom
-	void InitWiggle(BedReader& file, const ChromSizes& cSizes);
+	template<bool fixedStep>
+	void InitWiggle(BedReader& file, const char* fName, const ChromSizes& cSizes, eOInfo oinfo);
 
 public:
 	// Creates new instance by wig-file name
@@ -171,7 +522,8 @@ public:
 	//	@fName: file name
 	//	@cSizes: chrom sizes to control the chrom length exceedeng, or NULL if no control
 	//	@abortInval: true if invalid instance should abort excecution
-	Cover(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval);
+	//	@sink: receiver of the read chroms, or NULL if the instance keeps them
+	Cover(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval, ChromSink* sink = nullptr);
 
 	// Adds cover's item
 	bool operator()()
@@ -194,9 +546,16 @@ public:
 
 class ReadDens : public PlainCover
 {
-	using rfreq = map<chrlen, UINT>;
+	// 'PosFreqs' accumulates reads 5' positions within chrom.
+	// For the sorted input the forward positions are coming in order, so they are run-length encoded at once;
+	// the reverse ones are coming roughly in order and are sorted when the chrom is closed.
+	struct PosFreqs
+	{
+		vector<freqPair> Fwd;	// frequencies of forward reads positions
+		vector<chrlen>	 Rev;	// reverse reads positions
+	};
 
-	rfreq* _freq = nullptr;		// reads frequency; for constructor only
+	PosFreqs* _freqs = nullptr;	// reads frequency; for constructor only
 
 	// Gets an item's title.
 	//	@pl: true if plural form
@@ -213,11 +572,19 @@ public:
 	//	@fName: file name
 	//	@cSizes: chrom sizes to control the chrom length exceedeng, or NULL if no control
 	//	@abortInval: true if invalid instance should abort excecution
-	ReadDens(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval);
+	//	@sink: receiver of the read chroms, or NULL if the instance keeps them
+	ReadDens(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval, ChromSink* sink = nullptr);
 
 	// Adds Read
 	bool operator()() {
-		(*_freq)[_file->ItemStrand() ? _file->ItemStart() : _file->ItemEnd()]++;
+		if (_file->ItemStrand()) {
+			auto& fwd = _freqs->Fwd;
+			const chrlen pos = _file->ItemStart();
+			if (fwd.size() && fwd.back().first == pos)	fwd.back().second++;
+			else	fwd.emplace_back(pos, 1);
+		}
+		else
+			_freqs->Rev.push_back(_file->ItemEnd());
 		return true;
 	}
 
@@ -236,44 +603,102 @@ public:
 	void operator()(chrid cID, chrlen cLen, size_t cnt, size_t tCnt) { if (cnt) AddChrom(cID, cLen); }
 };
 
-// 'ChromRanges' represented a set of chromosome's ranges.
-struct ChromRanges : public ItemIndices
-	/*
-		To keep chromosome's number and first/last ranges indexes Features::ChromItemsInd is used;
-		FirstInd/LastInd are keeping first/last ranges indexes,
-		and lengths of all features from fs1, fs2 are keeping additionally for efficiency.
-	*/
+// 'ReadCover' represents chrom's coverage by reads or fragments initialized by alignment
+class ReadCover : public PlainCover
 {
-	chrlen FeatrsLen1;		// length of all features of chromosome in fs1
-	chrlen FeatrsLen2;		// length of all features of chromosome in fs2
+	// 'Borders' accumulates the starts and ends of reads or fragments within chrom.
+	// For the sorted input the starts are coming roughly in order, so they are sorted cheaply when the chrom is closed.
+	struct Borders
+	{
+		vector<chrlen> Starts;	// starts of covering regions
+		vector<chrlen> Ends;	// ends of covering regions
+	};
+
+	const chrlen	_fragLen;			// length to which reads are extended, or 0
+	Borders*		_borders = nullptr;	// covering regions borders; for constructor only
+	unique_ptr<FragIdent> _fIdent;		// paired-end fragments identifier, or NULL if reads are not paired
+
+	// Adds covering region
+	//	@start: region start
+	//	@end: region end
+	void AddRegion(chrlen start, chrlen end) {
+		_borders->Starts.push_back(start);
+		_borders->Ends.push_back(end);
+	}
+
+	// Adds chrom to the instance, sweeping the borders of covering regions
+	//	@cID: current chrom ID
+	//	@cLen: current chrom length
+	void AddChrom(chrid cID, chrlen cLen);
 
-	inline ChromRanges() : ItemIndices(), FeatrsLen1(0), FeatrsLen2(0) {}
+public:
+	// Creates new instance by abed/bam-file name
+	// Invalid instance wil be completed by throwing exception.
+	//	@fName: file name
+	//	@cSizes: chrom sizes to control the chrom length exceedeng, or NULL if no control
+	//	@abortInval: true if invalid instance should abort excecution
+	//	@sink: receiver of the read chroms, or NULL if the instance keeps them
+	ReadCover(const char* fName, ChromSizes& cSizes, eOInfo oinfo, bool abortInval, ChromSink* sink = nullptr);
+
+	// Adds Read
+	bool operator()();
 
-	inline ChromRanges(chrlen firstInd, chrlen lastInd, chrlen len1, chrlen len2) :
-		ItemIndices(firstInd, lastInd), FeatrsLen1(len1), FeatrsLen2(len2) {}
+	// Closes current chrom, open next one
+	//	@param cID: current chrom ID
+	//	@param cLen: current chrom length
+	//	@param cnt: current chrom items count
+	//	@param nextcID: next chrom ID
+	void operator()(chrid cID, chrlen cLen, size_t cnt, chrid nextcID) { if (cnt) AddChrom(cID, cLen); }
+
+	// Closes last chrom
+	//	@param cID: last chrom ID
+	//	@param cLen: current chrom length
+	//	@param cnt: last chrom items count
+	//	@param tCnt: total items count
+	void operator()(chrid cID, chrlen cLen, size_t cnt, size_t tCnt) { if (cnt) AddChrom(cID, cLen); }
+};
+
+// 'FeatureCover' represents features as 0/1 coverage to compare them with coverages and read densities
+class FeatureCover : public PlainCover
+{
+public:
+	// Creates new instance by features; overlapping and adjacent features are merged
+	//	@fs: features
+	//	@cSizes: chrom sizes
+	FeatureCover(const Features& fs, const ChromSizes& cSizes);
 };
 
 // 'JointedBeds' represents two bed-files as a chromosomes collection and theirs joint features (ranges).
 //	Fast but a bit complicated implementation of calculating algorithm.
-class JointedBeds : Chroms<ChromRanges>
+//	The ranges are not stored: they are merged chromosome by chromosome and fed directly to the accumulator.
+class JointedBeds
 {
-	// 'Range' represens a joint feature with start position and joint (combined) value.
-	struct Range
-		/*
-		All features from fs1, fs2 are splitted by contiguous ranges with predefined value:
-		VAL1 (only the first Features has a feature here), or
-		VAL2 (only the second Features has a feature here), or
-		VAL1 & VAL2 (both of the Beds have a feature here), or
-		0 (no features for both of the Beds)
-		*/
-	{
-		chrlen	Start;	// start position of range in standard chromosomal coordinates
-		char	Val;	// value of range
-
-		Range(chrlen pos = 0, char val = 0) : Start(pos), Val(val) {}
-	};
-
-	vector<Range> _ranges;
+	const Features& _fs1;
+	const Features& _fs2;
+	vector<chrid>	_cIDs;		// common chroms
+
+	// Merges chrom's features into the joint ranges and passes them to the callable object.
+	//	All features from fs1, fs2 are splitted by contiguous ranges with predefined value:
+	//	VAL1 (only the first Features has a feature here), or
+	//	VAL2 (only the second Features has a feature here), or
+	//	VAL1 & VAL2 (both of the Beds have a feature here), or
+	//	0 (no features for both of the Beds)
+	//	@cID: chrom's ID
+	//	@f: callable object with parameters (chrlen start, char val): start position and value of the next range
+	template<typename F>
+	void MergeChrom(chrid cID, F f) const;
+
+	// Accumulates chrom's ranges
+	//	@cID: chrom's ID
+	//	@cSize: chrom's size
+	//	@r: chrom accumulator
+	void CalcChromR(chrid cID, chrlen cSize, dsR& r) const;
+
+	// Prints chrom results and the total one
+	//	@cIDs: treated chroms
+	//	@chrRs: chrom results in the order of cIDs
+	//	@returns: true if calculation was actually done
+	static bool PrintChromRs(const vector<chrid>& cIDs, const vector<dsR>& chrRs);
 
 public:
 	// Two-Features constructor
@@ -281,23 +706,165 @@ public:
 	//	@param fs2: second valid features (no duplicated, crossed, adjacent, coverage features)
 	JointedBeds(const Features& fs1, const Features& fs2);
 
-	// Calculates r and fills results
+	// Calculates r and fills results; chroms are calculated in parallel
 	//	@param cSizes: chrom sizes
 	//	@returns: true if calculation was actually done
-	bool CalcR(const ChromSizes& cSizes);
+	bool CalcR(const ChromSizes& cSizes) const;
+
+	// Calculates r without printing
+	//	@cSizes: chrom sizes
+	//	@cIDs: treated chroms
+	//	@ccs: filled chrom coefficients in the order of cIDs (Undef for uncommon chrom), followed by the total one
+	void CalcR(const ChromSizes& cSizes, const vector<chrid>& cIDs, float* ccs) const;
+
+	// Calculates and prints r with several compared features in a single pass through the first ones
+	//	@fs1: first valid features
+	//	@fss: compared valid features
+	//	@cSizes: chrom sizes
+	//	@print: function called for each compared features in turn with its index
+	//	and the function printing its results, which returns true if calculation was actually done
+	static void CalcR(const Features& fs1, const vector<const Features*>& fss, const ChromSizes& cSizes,
+		const function<void(size_t, const function<bool()>&)>& print);
 
 #ifdef _DEBUG
-	void	Print();
+	void	Print() const;
 #endif
 };
 
+// 'ExtendedBeds' represents two bed-files, the first of which is extended step by step.
+//	The coefficients for all the extension steps are calculated in a single sweep through the features:
+//	the lengths of the features and their overlap are kept as a function of the extension.
+class ExtendedBeds
+{
+	// 'ChromExt' keeps chrom's lengths for each extension step
+	struct ChromExt
+	{
+		chrid	ID;
+		chrlen	FeatrsLen1;		// initial length of all features of chromosome in fs1
+		chrlen	FeatrsLen2;		// length of all features of chromosome in fs2
+		chrlen	CoverLen1;		// initial length covered by features of chromosome in fs1
+		chrlen	CoverLen2;		// length covered by features of chromosome in fs2
+		vector<chrlen> AddLen;	// length added to fs1 features by extension, for each step
+		vector<chrlen> Overlap;	// length of fs1 and fs2 features intersection, for each step
+
+		ChromExt(chrid cID) : ID(cID), FeatrsLen1(0), FeatrsLen2(0), CoverLen1(0), CoverLen2(0) {}
+	};
+
+	const Features& _fs1;
+	const Features& _fs2;
+	const ChromSizes& _cSizes;
+	const chrlen	_step;			// extension step
+	size_t			_stepCnt = 0;	// number of steps on which fs1 features are not crossed
+	vector<ChromExt> _chroms;
+
+	// Fills chrom's lengths for each step
+	//	@c: chrom's data
+	void FillChrom(ChromExt& c) const;
+
+public:
+	// Two-Features constructor
+	//	@param fs1: first  valid features (no duplicated, crossed, adjacent, coverage features)
+	//	@param fs2: second valid features (no duplicated, crossed, adjacent, coverage features)
+	//	@param cSizes: chrom sizes
+	//	@param step: extension step
+	//	@param maxLen: maximal extension length
+	ExtendedBeds(const Features& fs1, const Features& fs2, const ChromSizes& cSizes, chrlen step, chrlen maxLen);
+
+	// Returns true if the first features are crossed before the maximal extension length is reached
+	bool IsStopped(chrlen maxLen) const { return _stepCnt < maxLen / _step; }
+
+	// Returns the extension length on which the first features are crossed
+	chrlen StopLen() const { return chrlen(_stepCnt + 1) * _step; }
+
+	// Calculates r and prints results for each extension step
+	void CalcR() const;
+};
+
+// 'StrandCC' represents strand cross-correlation profile of alignment: coefficients between
+// forward and reverse read 5' densities, shifted relative to each other by each value in the range.
+// The profile is used to estimate fragment length and ChIP quality indexes NSC and RSC.
+class StrandCC
+{
+	// 'ChromDens' keeps read 5' densities of both strands within chrom
+	struct ChromDens
+	{
+		chrid	ID;
+		chrlen	Len;				// chrom length
+		vector<freqPair> Fwd;		// frequencies of forward reads positions
+		vector<freqPair> Rev;		// frequencies of reverse reads positions
+
+		ChromDens(chrid cID, chrlen len) : ID(cID), Len(len) {}
+	};
+
+	const chrlen	_maxShift;		// maximal shift
+	RBedReader*		_file = nullptr;	// for constructor only
+	vector<freqPair>	_fwd;		// frequencies of forward reads positions of current chrom; for constructor only
+	vector<chrlen>		_rev;		// reverse reads positions of current chrom; for constructor only
+	vector<size_t>		_readLens;	// frequencies of read lengths, indexed by length
+	vector<ChromDens>	_chroms;
+
+	// Adds chrom to the instance
+	//	@cID: current chrom ID
+	//	@cLen: current chrom length
+	void AddChrom(chrid cID, chrlen cLen);
+
+	// Accumulates sums of the chrom for all shifts at once
+	//	@cd: chrom densities
+	//	@rs: sums accumulators for each shift
+	void CalcChrom(const ChromDens& cd, spR* rs) const;
+
+public:
+	// Creates new instance by abed/bam-file name
+	//	@fName: file name
+	//	@cSizes: chrom sizes
+	//	@maxShift: maximal shift
+	//	@oinfo: verbose level
+	StrandCC(const char* fName, ChromSizes& cSizes, chrlen maxShift, eOInfo oinfo);
+
+	// Adds Read
+	bool operator()() {
+		if (_file->ItemStrand()) {
+			const chrlen pos = _file->ItemStart();
+			if (_fwd.size() && _fwd.back().first == pos)	_fwd.back().second++;
+			else	_fwd.emplace_back(pos, 1);
+		}
+		else
+			_rev.push_back(_file->ItemEnd());
+		const chrlen len = _file->ItemEnd() - _file->ItemStart();
+		if (len >= _readLens.size())	_readLens.resize(len + 1);
+		_readLens[len]++;
+		return true;
+	}
+
+	// Closes current chrom, open next one
+	//	@param cID: current chrom ID
+	//	@param cLen: current chrom length
+	//	@param cnt: current chrom items count
+	//	@param nextcID: next chrom ID
+	void operator()(chrid cID, chrlen cLen, size_t cnt, chrid nextcID) { if (cnt) AddChrom(cID, cLen); }
+
+	// Closes last chrom
+	//	@param cID: last chrom ID
+	//	@param cLen: current chrom length
+	//	@param cnt: last chrom items count
+	//	@param tCnt: total items count
+	void operator()(chrid cID, chrlen cLen, size_t cnt, size_t tCnt) { if (cnt) AddChrom(cID, cLen); }
+
+	// Fills profile
+	//	@ccs: filled coefficients for each shift
+	void CalcProfile(vector<float>& ccs) const;
+
+	// Calculates and prints profile, estimated fragment length and quality indexes
+	void CalcR() const;
+};
+
 
 // 'CorrPair' represents pair of objects to compare, and methods for recognizing types and calculation CC
 class CorrPair
 {
 	// Pointers to the common methods
 	struct FileType {
-		void* (CorrPair::* Create)(const char*, bool);	// type constructor
+		void* (CorrPair::* Create)(const char*, FT::eType, eOInfo, bool);	// type constructor
 		void(*Delete)(void*);							// type destructor
 	};
 
@@ -308,34 +875,64 @@ class CorrPair
 	Features* _templ = nullptr;
 	DefRegions& _gRgns;		// initial genome regions to correlate
 	FT::eType	_type;		// type of compared files
-	BYTE	_typeInd;		// type of file types: 0 - wig, 1 - bedF, 2 - bedR
+	BYTE	_typeInd;		// type of primary file: 0 - wig, 1 - bedF, 2 - bedR, 3 - bedF as coverage
+	BYTE	_secondInd = 0;	// type of secondary object, which may differ from the primary one
+	bool	_stream = false;	// true if secondary covers are not kept in memory
+	ofstream	_wccFile;		// file of coefficients in sliding windows; not open if they are not required
 
 	// Returns true if Features are treating
 	inline bool IsBedF()	const { return _typeInd == 1; }
 
+	// Returns true if secondary objects can be loaded concurrently.
+	// Chrom sizes which are not defined by the genome are filled by the readers, so they cannot be shared.
+	inline bool IsConcurrentLoad() const { return _gRgns.ChrSizes().IsFilled(); }
+
+	// Releases secondary object
+	void DeleteSecond() {
+		_FileTypes[_secondInd].Delete(_secondObj);
+		_secondObj = nullptr;
+	}
+
 	// Throws an exception if no items, or prints LF while needed
+	//	@type: file type
+	//	@oinfo: verbose level
 	template<typename T>
-	void CheckItemsCount(T* obj, const char* fName)	{
-		if (!obj->ItemsCount()) 
-			PrintMngr::CompleteEmpty(fName, _type);
-		else if (PrintMngr::IsPrNameOnly())
+	void CheckItemsCount(T* obj, const char* fName, FT::eType type, eOInfo oinfo)	{
+		if (!obj->ItemsCount()) {
+			unique_ptr<T> guard(obj);	// release object before throwing
+			PrintMngr::CompleteEmpty(fName, type);
+		}
+		else if (oinfo != eOInfo::NONE && PrintMngr::IsPrNameOnly())
 			dout << LF;
 	}
 
 	// Creates features bed object.
 	//	@fName: file name
+	//	@type: file type
+	//	@oinfo: verbose level
 	//	@primary: if true object is primary
-	void* CreateBedF(const char* fName, bool isPrimary);
+	void* CreateBedF(const char* fName, FT::eType type, eOInfo oinfo, bool isPrimary);
 
 	// Creates alignment object
 	//	@fName: file name
+	//	@type: file type
+	//	@oinfo: verbose level
 	//	@primary: if true object is primary
-	void* CreateBedR(const char* fName, bool isPrimary);
+	void* CreateBedR(const char* fName, FT::eType type, eOInfo oinfo, bool isPrimary);
 
 	// Creates covering object.
 	//	@fName: file name
+	//	@type: file type
+	//	@oinfo: verbose level
 	//	@primary: if true object is primary
-	void* CreateWig(const char* fName, bool isPrimary);
+	void* CreateWig(const char* fName, FT::eType type, eOInfo oinfo, bool isPrimary);
+
+	// Creates features bed object represented as 0/1 coverage.
+	//	@fName: file name
+	//	@type: file type
+	//	@oinfo: verbose level
+	//	@primary: if true object is primary
+	void* CreateBedFCover(const char* fName, FT::eType type, eOInfo oinfo, bool isPrimary);
 
 	// Calculates r for genome features.
 	//	@firstBed: first Features to correlate
@@ -346,9 +943,45 @@ class CorrPair
 
 	// Calculates r for coverages and read densities
 	bool CalcCCCover(DefRegions& gRgns) {
-		return ((Cover*)_firstObj)->CalcR(*((Cover*)_secondObj), gRgns, _templ);
+		return ((PlainCover*)_firstObj)->CalcR(*((PlainCover*)_secondObj), gRgns, _templ);
 	}
 
+	// Calculates r for coverages and read densities, merging secondary cover as it is read
+	//	@fName: secondary file's name
+	bool CalcCCStream(const char* fName);
+
+	// Returns index in _FileTypes of the primary object.
+	// Ordinary bed is treated as coverage if any secondary file is coverage or alignment.
+	//	@fNames: files' names, including the primary one
+	//	@cnt: number of files
+	BYTE PrimaryInd(char** fNames, short cnt);
+
+	// Returns index in _FileTypes of the secondary object, or vUNDEF if it cannot be compared with the primary one.
+	// Ordinary bed is treated as coverage if the primary object is coverage-like.
+	//	@fName: secondary file's name
+	char SecondaryInd(const char* fName);
+
+	// Calculates and prints CC between primary and current secondary objects
+	//	@fName: secondary file's name
+	void CalcCC2(const char* fName);
+
+	// Calculates and prints CC between primary and secondary features extended step by step
+	//	@second: secondary features
+	//	@fName: secondary file's name
+	void CalcCCExt(const Features& second, const char* fName);
+
+	// Adds secondary objects by batches, calculates and prints CC.
+	// The batch is loaded in parallel and correlated with the primary object in a single pass.
+	//	@fNames: secondary files' names
+	//	@cnt: number of secondary files
+	//	@batch: max number of secondaries in the batch
+	void CalcCCBatch(char** fNames, short cnt, short batch);
+
+	// Converts cover to compact or dense layout if required, and prints its memory usage
+	//	@cv: created cover
+	//	@oinfo: verbose level
+	void CompleteCover(PlainCover* cv, eOInfo oinfo) const;
+
 	// Checks file extisting and extention validity
 	//	@fName: file's name
 	//	@abortInvalid: if true throw extention if checking is false
@@ -357,14 +990,102 @@ class CorrPair
 
 public:
 	// Creates an instance with checking primary object.
-	//	@primefName: primary file's name
+	//	@fNames: files' names, the first one is primary
+	//	@cnt: number of files
 	//	@gRgns: genome regions
 	//	@templ: name of template bed file, or NULL if undefined
-	//	@multiFiles: true if more then one secondary files are placed
-	CorrPair(const char* primefName, DefRegions& gRgns, const char* templ, bool multiFiles);
+	CorrPair(char** fNames, short cnt, DefRegions& gRgns, const char* templ);
 
 	~CorrPair();
 
-	// Adds secondary object, calculates and prints CCkey.
+	// Adds secondary object, calculates and prints CC.
 	void CalcCC(const char* fName);
+
+	// Adds secondary objects by turn, calculates and prints CC.
+	// Secondaries are loaded in the background in advance, while the current pair is correlated.
+	//	@fNames: secondary files' names
+	//	@cnt: number of secondary files
+	//	@preload: max number of secondaries loaded in advance; if 0 then they are loaded by turn
+	//	@batch: max number of secondaries correlated in a single pass; if 0 then they are correlated by turn
+	void CalcCC(char** fNames, short cnt, BYTE preload, short batch = 0);
+
+	// Calculates CC between all the objects and writes them as a matrix
+	//	@fNames: files' names, including the primary one
+	//	@cnt: number of files
+	//	@oName: name of the output matrix file
+	void CalcMatrix(char** fNames, short cnt, const char* oName);
+};
+
+// 'BinStore' represents the persistent store of the binned covers of many samples, mapped into memory.
+// Within each chrom each sample is kept as a separate column of bins, split into chunks of fixed number of bins.
+// Each chunk keeps the sums of its values and of their squares; uniform chunks keep their value only.
+// The file keeps the native layout, so it is not intended to be moved between platforms.
+class BinStore
+{
+public:
+	static const UINT ChunkLen = 4096;	// number of bins in the chunk
+
+	// 'Chunk' is the entry of the chunk table
+	struct Chunk {
+		double	Sum;		// sum of the values
+		double	SumSqr;		// sum of the squared values
+		size_t	Offset;		// offset of the values in the file, or 0 if the chunk is uniform
+		float	Val;		// value of the uniform chunk
+	};
+
+	// 'Column' is the entry of the column table: the bins of the sample within the chrom
+	struct Column {
+		size_t	FirstChunk;	// index of the first chunk in the chunk table
+		UINT	Sample;		// index of the sample
+		UINT	BinCnt;		// number of bins
+		chrid	ID;			// chrom
+	};
+
+private:
+	unique_ptr<MappedFile>	_file;
+	chrlen			_binLen = 0;			// length of bin
+	const Chunk*	_chunks = nullptr;		// chunk table
+	vector<const char*>	_samples;			// names of the samples
+	map<chrid, vector<const Column*>> _chroms;	// columns for each chrom by the sample index; NULL if absent
+
+	// Returns values of the chunk, or NULL if the chunk is uniform
+	const float* Values(const Chunk& ch) const
+	{ return ch.Offset ? (const float*)(_file->Data() + ch.Offset) : nullptr; }
+
+	// Accumulates sums of two columns within the chrom
+	//	@colX: first column
+	//	@colY: second column
+	//	@chrR: chrom sums accumulator
+	void CalcChromR(const Column& colX, const Column& colY, spR& chrR) const;
+
+	// Fills the coefficients of two samples for each chrom followed by the total one
+	//	@x: first sample index
+	//	@y: second sample index
+	//	@cIDs: treated chroms
+	//	@ccs: coefficients; Undef if the chrom is absent in any sample
+	//	return: true if at least one chrom is treated
+	bool CalcR(UINT x, UINT y, const vector<chrid>& cIDs, float* ccs) const;
+
+public:
+	// Returns true if file is a store
+	//	@fName: file name
+	static bool IsStore(const char* fName);
+
+	// Creates store of the covers binned by the length given by --bin option.
+	// Samples are loaded and binned in parallel by the groups of the threads number.
+	//	@fNames: input files' names
+	//	@cnt: number of input files
+	//	@cSizes: chrom sizes
+	//	@sName: store file name
+	static void Build(char** fNames, short cnt, ChromSizes& cSizes, const char* sName);
+
+	// Maps existing store into memory
+	//	@fName: store file name
+	BinStore(const char* fName);
+
+	// Calculates and prints CC between the first selected sample and the others,
+	// or between all of them written as a matrix
+	//	@samples: comma-separated names of the selected samples, or NULL if all the samples are selected
+	//	@oName: name of the output matrix file, or NULL if matrix is not required
+	void CalcR(const char* samples, const char* oName) const;
 };
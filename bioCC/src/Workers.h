@@ -0,0 +1,147 @@
+/**********************************************************
+Workers.h
+Provides a simple pool of threads for independent jobs
+2026 Fedor Naumenko (fedor.naumenko@gmail.com)
+Last modified: 10/16/2026
+***********************************************************/
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <deque>
+
+// 'Workers' runs indexed independent jobs on a pool of threads
+class Workers
+{
+	static BYTE _count;		// number of threads
+
+public:
+	// Sets number of threads
+	inline static void SetCount(int cnt) { _count = BYTE(cnt > 0 ? cnt : 1); }
+
+	// Returns number of threads
+	inline static BYTE Count() { return _count; }
+
+	// Calls job(i) for each i in [0, cnt).
+	// Indexes are dealt out to threads dynamically, so the order of calls is undefined;
+	// the caller is responsible for the deterministic consolidation of the results.
+	// The first exception thrown by any job stops dealing and is rethrown in the calling thread.
+	//	@cnt: number of jobs
+	//	@job: callable object with size_t parameter
+	template<typename F>
+	static void Run(size_t cnt, F job)
+	{
+		const size_t thrCnt = _count < cnt ? _count : cnt;
+
+		if (thrCnt <= 1) {		// serial mode
+			for (size_t i = 0; i < cnt; i++)	job(i);
+			return;
+		}
+		std::atomic<size_t> next(0);	// index of next job
+		std::exception_ptr excp;
+		std::mutex mtx;
+		auto work = [&]() {
+			try {
+				for (size_t i; (i = next++) < cnt; )	job(i);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mtx);
+				if (!excp)	excp = std::current_exception();
+				next = cnt;		// stop dealing
+			}
+		};
+		std::vector<std::thread> threads;
+
+		threads.reserve(thrCnt - 1);
+		for (size_t i = 1; i < thrCnt; i++)
+			threads.emplace_back(work);
+		work();					// the calling thread is a worker as well
+		for (auto& t : threads)	t.join();
+		if (excp)	std::rethrow_exception(excp);
+	}
+
+	// 'Queue' runs jobs on a pool of threads while the caller goes on producing them.
+	// The number of jobs waiting for a free thread is limited, so the caller is suspended while the pool is busy.
+	// Since the caller is not a worker, producing overlaps with the jobs even for a single thread.
+	// The first exception thrown by any job discards the waiting jobs and is rethrown by Push() or Wait().
+	class Queue
+	{
+		std::deque<std::function<void()>> _jobs;	// jobs waiting for a free thread
+		std::vector<std::thread> _threads;
+		std::mutex		_mtx;
+		std::condition_variable _jobReady;		// signals that a job is waiting or the queue is closed
+		std::condition_variable _slotFree;		// signals that a job is taken or failed
+		std::exception_ptr _excp;
+		const size_t	_maxWaiting;			// maximum number of waiting jobs
+		bool			_closed = false;
+
+		// Takes waiting jobs until the queue is closed and empty
+		void Work()
+		{
+			for (std::function<void()> job;;) {
+				{
+					std::unique_lock<std::mutex> lock(_mtx);
+					_jobReady.wait(lock, [this] { return _closed || !_jobs.empty(); });
+					if (_jobs.empty())	return;
+					job = std::move(_jobs.front());
+					_jobs.pop_front();
+				}
+				_slotFree.notify_one();
+				try { job(); }
+				catch (...) {
+					std::lock_guard<std::mutex> lock(_mtx);
+					if (!_excp)	_excp = std::current_exception();
+					_jobs.clear();
+				}
+				_slotFree.notify_all();
+			}
+		}
+
+		// Waits for all the jobs and stops the threads
+		void Close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mtx);
+				_closed = true;
+			}
+			_jobReady.notify_all();
+			for (auto& t : _threads)
+				if (t.joinable())	t.join();
+		}
+
+	public:
+		// Starts Workers::Count() threads
+		//	@maxWaiting: maximum number of jobs waiting for a free thread
+		Queue(size_t maxWaiting = 1) : _maxWaiting(maxWaiting ? maxWaiting : 1)
+		{
+			_threads.reserve(_count);
+			for (BYTE i = 0; i < _count; i++)
+				_threads.emplace_back(&Queue::Work, this);
+		}
+
+		~Queue() { Close(); }
+
+		// Adds job; waits while the number of waiting jobs reaches the limit
+		void Push(std::function<void()>&& job)
+		{
+			std::unique_lock<std::mutex> lock(_mtx);
+			_slotFree.wait(lock, [this] { return _excp || _jobs.size() < _maxWaiting; });
+			if (_excp)	std::rethrow_exception(_excp);
+			_jobs.push_back(std::move(job));
+			lock.unlock();
+			_jobReady.notify_one();
+		}
+
+		// Waits for all the jobs; rethrows the first exception thrown by them
+		void Wait()
+		{
+			Close();
+			if (_excp)	std::rethrow_exception(_excp);
+		}
+	};
+};
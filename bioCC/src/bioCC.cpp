@@ -9,7 +9,7 @@ bioCC is designed to treat a bunch of files at once.
 
 Copyright (C) 2017 Fedor Naumenko (fedor.naumenko@gmail.com)
 -------------------------
-Last modified: 07/26/2024
+Last modified: 10/16/2026
 -------------------------
 
 This program is free software. It is distributed in the hope that it will be useful,
@@ -19,6 +19,7 @@ See the	GNU General Public License for more details.
 ************************************************************************************/
 
 #include "Calc.h"
+#include "Workers.h"
 #include <string>
 #include <algorithm>
 
@@ -36,6 +37,8 @@ const char* prCCs[] = { "LOC", "TOT" };		// corresponds to eTotal; totalOFF is h
 const char* fsort[] = { "RGN", "CC" };		// corresponds to eRS; rsOFF is hidden
 // --oinfo option: types of oinfo notations
 const char* infos[] = { "LAC", "NM", "ITEM", "STAT" };	// corresponds to eOInfo; iNONE is hidden
+// --approx option: levels of pyramid notations
+const char* approxLvls[] = { "1K", "10K", "100K" };	// corresponds to PlainCover::Pyramid::WinLens
 
 const char* ForAligns = "For the alignments only";
 const char* IgnoreBed = "Ignored for the ordinary beds";
@@ -61,16 +64,40 @@ Options::Option Options::List[] = {
 	{ HPH,"gap-len",tOpt::HIDDEN,tINT,	gINPUT,	1000, 50, 1e5, NULL,
 	"minimal length of undefined nucleotide region in genome\nwhich is declared as a gap.\nIgnored for the chromosome sizes file and for the ordinary beds", NULL },
 	{ 'd', "dup",	tOpt::NONE,	tENUM,	gINPUT, TRUE,	0, 2, (char*)Booleans, "allow duplicate reads.", ForAligns },
+	{ HPH, "cover",	tOpt::NONE,	tENUM,	gINPUT, FALSE,	vUNDEF, 2, NULL,
+	"correlate coverages by reads or fragments instead of read densities.", ForAligns },
+	{ HPH, "frag-len",	tOpt::NONE,	tINT,	gINPUT, 0, 0, 1e4, NULL,
+	"length to which the reads are extended with --cover.\nIf 0 then paired-end fragments or the reads themselves are used.", ForAligns },
 	{ 'o', "overl",	tOpt::NONE,	tENUM,	gINPUT, FALSE,	0, 2, (char*)Booleans,
 	"allow (and merge) overlapping features. For the ordinary beds only", NULL },
+	{ HPH, "compact",	tOpt::NONE,	tENUM,	gINPUT, FALSE,	vUNDEF, 2, NULL,
+	"keep coverages and read densities in compact layout to reduce memory usage", NULL },
+	{ HPH, "cache",	tOpt::NONE,	tENUM,	gINPUT, FALSE,	vUNDEF, 2, NULL,
+	"cache parsed coverages and read densities in binary files next to the sources", NULL },
 	{ 'l', "list",	tOpt::NONE,	tNAME,	gINPUT, vUNDEF, 0, 0, NULL,
 	"list of multiple input files.\nFirst (primary) file in list is comparing with others (secondary)", NULL },
+	{ 'P', "preload",	tOpt::NONE,	tINT,	gINPUT, 0, 0, 2, NULL,
+	"number of secondary files loaded in advance in the background,\nwhile the current pair is correlated. If 0 then no preloading", NULL },
+	{ HPH, "stream",	tOpt::NONE,	tENUM,	gINPUT, FALSE,	vUNDEF, 2, NULL,
+	"do not keep secondary coverages and read densities in memory:\nmerge them with the primary one chromosome by chromosome while reading.\nCancels preloading", NULL },
+	{ HPH, "batch",	tOpt::NONE,	tINT,	gINPUT, 0, 0, 1e3, NULL,
+	"number of secondary files loaded together and correlated with the primary one\nin a single pass. If 0 then secondary files are correlated by turn.\nCancels preloading, ignored with --stream", NULL },
+	{ HPH, "store",	tOpt::NONE,	tNAME,	gINPUT, vUNDEF, 0, 0, NULL,
+	"build the store of input coverages, read densities and features binned by --bin\nin specified file instead of correlating them.\nThe store file with '.bcs' extension is accepted as a single input file", NULL },
+	{ HPH, "samples",	tOpt::NONE,	tNAME,	gINPUT, vUNDEF, 0, 0, NULL,
+	"comma-separated names of the store samples to correlate;\nthe first one is primary. If not set then all the samples are correlated", NULL },
 	{ 'f', "fbed",	tOpt::NONE,	tNAME,	gTREAT, vUNDEF,	0, 0, NULL,
 	"'template' ordinary bed file which features define compared regions.", IgnoreBed},
 	{ 'e', "ext-len",	tOpt::NONE,	tINT,	gTREAT,0, 0, 2e4, NULL,
 	"length by which the features in primary file (for ordinary beds) or in\n'template' (for alignments and wigs) will be extended in both directions\nbefore treatment", NULL },
 	{ 's', "ext-step",	tOpt::NONE,	tINT,	gTREAT,0, 0, 500, NULL,
 	"step of extending features in primary bed file;\nif 0 then no step calculation. For the ordinary beds only", NULL },
+	{ HPH, "bin",	tOpt::NONE,	tINT,	gTREAT,	0, 0, 1e5, NULL,
+	"length of bins in which coverages and read densities are averaged\nbefore correlation. If 0 then they are correlated base by base.\nIgnored with 'template'; cancels --stream", NULL },
+	{ HPH, "approx",	tOpt::NONE,	tENUM,	gTREAT,	0, 1, 3, (char*)approxLvls,
+	"approximate coefficients by the sums over the windows of given length\nand print the bound of their deviation from the exact ones.\nIgnored with 'template'; cancels --bin and --stream", NULL },
+	{ HPH, "scc",	tOpt::NONE,	tINT,	gTREAT,	0, 0, 5000, NULL,
+	"calculate strand cross-correlation profile of each alignment up to given shift,\nand estimate fragment length and NSC/RSC quality indexes.\nIf 0 then no calculation", NULL },
 	{ 'R',	"pr-cc",	tOpt::NONE,	tCOMB,	gOUTPUT, PrintMngr::LOC, PrintMngr::LOC, PrintMngr::TOT, (char*)prCCs,
 	"print coefficient, in any order:\n? - for each chromosome, ? - total", NULL },
 	{ 'B', "bin-width",	tOpt::NONE,	tFLOAT,	gOUTPUT,0, 0, 1.0F, NULL,
@@ -80,9 +107,19 @@ Options::Option Options::List[] = {
 	"print region coefficients, sorted by: ? - regions, ? - coefficients", NULL },
 	{ 'V', "verbose ",	tOpt::NONE,	tENUM, gOUTPUT,	float(eOInfo::NM), float(eOInfo::LAC), float(eOInfo::STAT), (char*)infos,
 	"set verbose level:\n?  - laconic\n?   - file names\n? - file names and number of items\n? - file names and items statistics", NULL },
+	{ 'M', "matrix",	tOpt::NONE,	tNAME,	gOUTPUT, vUNDEF, 0, 0, NULL,
+	"compare all input files with each other and write the matrix\nof coefficients to specified TSV file", NULL },
+	{ HPH, "wcc",	tOpt::NONE,	tNAME,	gOUTPUT, vUNDEF, 0, 0, NULL,
+	"write coefficients in sliding windows to specified bedGraph file.\nFor alignments and wigs only; cancels --bin, --approx, --stream and --batch", NULL },
+	{ HPH, "wcc-len",	tOpt::NONE,	tINT,	gOUTPUT, 5000, 100, 1e7, NULL,
+	"length of sliding window for --wcc", NULL },
+	{ HPH, "wcc-step",	tOpt::NONE,	tINT,	gOUTPUT, 500, 10, 1e6, NULL,
+	"step of sliding window for --wcc", NULL },
 	{ 'w', "write",	tOpt::HIDDEN,tENUM,	gOUTPUT,FALSE,	vUNDEF, 2, NULL,
 	"write each inner representation to file with '_out' suffix", NULL },
 	{ 'O', sOutput,	tOpt::FACULT,tNAME,	gOUTPUT,NO_DEF,	0,	0, NULL, DoutHelp(Product::Title.c_str()), NULL },
+	{ 'p', "threads",tOpt::NONE,tINT,	gOTHER,	1, 1, 64, NULL,
+	"number of threads used to compute the chromosomes simultaneously", NULL },
 	{ 't', sTime,	tOpt::NONE,	tENUM,	gOTHER,	FALSE,	vUNDEF, 2, NULL, sHelpTime, NULL },
 	{ HPH, sSumm,	tOpt::HIDDEN,tSUMM,	gOTHER,	vUNDEF, vUNDEF, 0, NULL, sHelpSummary, NULL },
 	{ 'v', sVers,	tOpt::NONE,	tVERS,	gOTHER,	vUNDEF, vUNDEF, 0, NULL, sHelpVersion, NULL },
@@ -98,7 +135,10 @@ const BYTE Options::UsageCount = ArrCnt(Options::Usages);
 
 dostream dout;	// stream's duplicator
 
+BYTE Workers::_count = 1;
+
 /*****************************************/
+#ifndef _BIOCC_TEST		// regression tests have their own entry point
 int main(int argc, char* argv[])
 {
 	int fileInd = Options::Parse(argc, argv);
@@ -107,6 +147,7 @@ int main(int argc, char* argv[])
 
 	Chrom::SetUserChrom(Options::GetSVal(oCHROM));
 	Timer::Enabled = Options::GetBVal(oTIME);
+	Workers::SetCount(Options::GetIVal(oTHREADS));
 	Timer timer;
 	try {
 		char** inFiles;
@@ -126,29 +167,50 @@ int main(int argc, char* argv[])
 		else
 			inFiles = argv + fileInd,
 			inFilesCnt = argc - fileInd;
-		if (inFilesCnt < 2)			// check input files
+		const chrlen maxShift = Options::GetIVal(oSCC);
+		const char* sName = Options::GetSVal(oSTORE);
+		const bool isStore = inFilesCnt && BinStore::IsStore(inFiles[0]);
+		if (inFilesCnt < (maxShift || sName || isStore ? 1 : 2))	// check input files
 			Err(Err::MISSED, NULL, inFilesCnt ? "secondary " + InFiles : InFiles).Throw();
 
 		// set genom
 		const char* gName = Options::GetSVal(oGENOM);
-		if (!gName && !FS::HasExt(inFiles[0], FT::Ext(FT::eType::BAM)))
+		if (!gName && !isStore && !FS::HasExt(inFiles[0], FT::Ext(FT::eType::BAM)))
 			Err(Options::OptionToStr(oGENOM) + " is required for all the file types except BAM",
 				inFiles[0]).Throw();
+		if (!gName && sName)	// samples are read in parallel, so chrom sizes cannot be filled by them
+			Err(Options::OptionToStr(oGENOM) + " is required to build the store", sName).Throw();
 
 		// set output file
 		Options::SetDoutFile(oDOUT_FILE, Product::Title.c_str());
 
 		ChromSizes cSizes(gName, true);
-		DefRegions gRgn(cSizes, Options::GetIVal(oGAP_LEN));
-		CorrPair cPair(inFiles[0], gRgn, Options::GetSVal(oFBED), inFilesCnt > 2);
-		for (short i = 1; i < inFilesCnt; i++)
-			cPair.CalcCC(inFiles[i]);
+		if (maxShift)				// each alignment is treated on its own
+			for (short i = 0; i < inFilesCnt; i++) {
+				if (inFilesCnt > 1)	dout << inFiles[i] << LF;
+				StrandCC(inFiles[i], cSizes, maxShift, eOInfo(Options::GetIVal(oVERB))).CalcR();
+			}
+		else if (isStore)			// samples are correlated directly in the mapped store
+			BinStore(inFiles[0]).CalcR(Options::GetSVal(oSAMPLES), Options::GetSVal(oMATRIX));
+		else if (sName)
+			BinStore::Build(inFiles, inFilesCnt, cSizes, sName);
+		else {
+			DefRegions gRgn(cSizes, Options::GetIVal(oGAP_LEN));
+			CorrPair cPair(inFiles, inFilesCnt, gRgn, Options::GetSVal(oFBED));
+			const char* mName = Options::GetSVal(oMATRIX);
+			if (mName)
+				cPair.CalcMatrix(inFiles, inFilesCnt, mName);
+			else
+				cPair.CalcCC(inFiles + 1, inFilesCnt - 1,
+					BYTE(Options::GetIVal(oPRELOAD)), short(Options::GetIVal(oBATCH)));
+		}
 	}
 	catch (const Err & e)		{ ret = 1; cerr << e.what() << LF; }
 	catch (const exception & e) { ret = 1; cerr << SPACE << e.what() << LF; }
 	timer.Stop();
 	return ret;
 }
+#endif	// _BIOCC_TEST
 
 /************************ class FileList ************************/
 //#ifdef OS_Windows
@@ -2,7 +2,7 @@
 bioCC.h
 Provides option emum and FileList class
 2014 Fedor Naumenko (fedor.naumenko@gmail.com)
-Last modified: 07/25/2024
+Last modified: 10/16/2026
 ***********************************************************/
 #pragma once
 
@@ -12,17 +12,34 @@ enum optValue {
 	oCHROM,
 	oGAP_LEN,
 	oDUPL,
+	oCOVER,
+	oFRAG_LEN,
 	oOVERL,
+	oCOMPACT,
+	oCACHE,
 	oFILE_LIST,
+	oPRELOAD,
+	oSTREAM,
+	oBATCH,
+	oSTORE,
+	oSAMPLES,
 	oFBED,
 	oEXT_LEN,
 	oEXT_STEP,
+	oBIN,
+	oAPPROX,
+	oSCC,
 	oPR_CC,
 	oBIN_WIDTH,
 	oPR_FCC,
 	oVERB,
+	oMATRIX,
+	oWCC,
+	oWCC_LEN,
+	oWCC_STEP,
 	oWRITE,
 	oDOUT_FILE,
+	oTHREADS,
 	oTIME,
 	oVERSION,
 	oSUMM,
@@ -0,0 +1,728 @@
+/**********************************************************
+CalcTest.cpp
+Regression tests: compare the results of the parallel, compact, cached and approximated
+calculations with the serial or brute-force ones on small generated data
+2026 Fedor Naumenko (fedor.naumenko@gmail.com)
+Last modified: 10/17/2026
+***********************************************************/
+
+// The kernels have file scope, so the test is compiled with Calc.cpp included;
+// the test target leaves Calc.cpp out of its sources, so nothing is defined twice
+#include "Calc.cpp"
+#include <random>
+
+static const char* GName = "test.chrom.sizes";		// chrom sizes fixture
+static const char* G2Name = "test.chrom.sizes2";	// chrom sizes fixture with the swapped lengths
+static const char* TName = "test.templ.bed";		// template fixture
+static const char* RName = "test.reads.bed";		// alignment fixture
+static const char* SName = "test.bcs";				// store fixture
+static const char* MName = "test.matrix.tsv";		// matrix of the store samples
+static const chrlen CLens[] = { 200003, 150001, 60000 };	// lengths of the fixture chroms
+
+static int FailCnt = 0;		// number of failed checks
+
+// Counts and prints failed check
+//	@cond: checked condition
+//	@test: test title
+//	@msg: failure details
+//	return: cond
+bool Check(bool cond, const char* test, const string& msg)
+{
+	if (!cond) {
+		FailCnt++;
+		cerr << test << ": " << msg << LF;
+	}
+	return cond;
+}
+
+// Returns true if coefficients are bitwise identical
+inline bool Same(float cc1, float cc2) { return !memcmp(&cc1, &cc2, sizeof(float)); }
+
+// 'TestCover' is the cover filled by the generated items
+class TestCover : public PlainCover
+{
+public:
+	using PlainCover::FillChromRs;
+	using PlainCover::LoadCache;
+	using PlainCover::SaveCache;
+
+	// Adds chrom
+	//	@cID: chrom
+	//	@items: chrom's items
+	void Add(chrid cID, const vector<ValPos>& items) {
+		const size_t first = _items.size();
+		_items.insert(_items.end(), items.begin(), items.end());
+		AddVal(cID, ItemIndices(first, _items.size()));
+	}
+};
+
+// Returns chrom's items with random lengths and values, closed by zero item at the chrom end
+//	@g: random generator
+//	@cLen: chrom length
+//	@maxLen: maximal length of item
+//	@valCnt: number of different values
+//	@frac: true if values are fractional
+vector<ValPos> RandomItems(mt19937& g, chrlen cLen, chrlen maxLen, UINT valCnt, bool frac = false)
+{
+	vector<ValPos> items;
+
+	for (chrlen pos = g() % maxLen; pos < cLen; pos += 1 + g() % maxLen)
+		items.emplace_back(pos, frac ? float(g() % valCnt) / 7 : float(g() % valCnt));
+	items.emplace_back(cLen);
+	return items;
+}
+
+// Fills cover with random items for each chrom
+//	@cv: filled cover
+//	@cSizes: chrom sizes
+//	@g: random generator
+//	@maxLen: maximal length of item
+//	@valCnt: number of different values
+//	@frac: true if values are fractional
+void Fill(TestCover& cv, const ChromSizes& cSizes, mt19937& g, chrlen maxLen, UINT valCnt, bool frac = false)
+{
+	for (auto it = cSizes.cBegin(); it != cSizes.cEnd(); it++)
+		cv.Add(CID(it), RandomItems(g, cSizes[CID(it)], maxLen, valCnt, frac));
+}
+
+// Returns values of the chrom's items at each position
+//	@items: chrom's items
+//	@cLen: chrom length
+vector<double> Dense(const vector<ValPos>& items, chrlen cLen)
+{
+	vector<double> vals(cLen, 0);
+
+	for (size_t i = 0; i + 1 < items.size(); i++)
+		fill(vals.begin() + items[i].Pos, vals.begin() + min(items[i + 1].Pos, cLen), items[i].Val);
+	return vals;
+}
+
+// Workers: all the jobs are done on any number of threads; the first job exception is passed to the caller
+void TestWorkers()
+{
+	const char* title = "Workers";
+	const size_t cnt = 1000;
+
+	for (BYTE thrCnt : { 1, 4 }) {
+		Workers::SetCount(thrCnt);
+		vector<size_t> vals(cnt, 0);
+		Workers::Run(cnt, [&](size_t i) { vals[i] = i * i; });
+		for (size_t i = 0; i < cnt; i++)
+			if (!Check(vals[i] == i * i, title, "job " + to_string(i) + " is not done"))	break;
+
+		atomic<size_t> sum(0);
+		Workers::Queue queue(2);
+		for (size_t i = 0; i < cnt; i++)
+			queue.Push([&sum, i] { sum += i; });
+		queue.Wait();
+		Check(sum == cnt * (cnt - 1) / 2, title, "queued jobs are lost on " + to_string(thrCnt) + " threads");
+
+		bool thrown = false;
+		try {
+			Workers::Queue q;
+			for (size_t i = 0; i < cnt; i++)
+				q.Push([i] { if (i == 10) throw runtime_error("job"); });
+			q.Wait();
+		}
+		catch (const runtime_error&) { thrown = true; }
+		Check(thrown, title, "queued job exception is lost on " + to_string(thrCnt) + " threads");
+	}
+	Workers::SetCount(1);
+}
+
+// Compares chrom results
+//	@title: test title
+//	@cID: chrom
+//	@r1: first result
+//	@r2: second result
+void CheckSame(const char* title, chrid cID, ChromR& r1, ChromR& r2)
+{
+	const string chr = Chrom::AbbrName(cID);
+
+	Check(Same(r1.R.PCC(), r2.R.PCC()), title, chr + ": " + to_string(r1.R.PCC()) + " vs " + to_string(r2.R.PCC()));
+	if (!Check(r1.LocResults.size() == r2.LocResults.size(), title, chr + ": different number of features"))
+		return;
+	for (size_t i = 0; i < r1.LocResults.size(); i++)
+		if (!Check(r1.LocResults[i].first == r2.LocResults[i].first
+			&& Same(r1.LocResults[i].second, r2.LocResults[i].second),
+			title, chr + ": feature " + to_string(r1.LocResults[i].first)))
+			break;
+}
+
+// Parallel calculation by chroms and spans of features gives the same results on any number of threads,
+// and the same results as the serial calculation of the whole chrom
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+//	@templ: template
+void TestThreads(const ChromSizes& cSizes, const vector<chrid>& cIDs, const Features& templ)
+{
+	const char* title = "Threads";
+	mt19937 g(1);
+	TestCover x, y;
+
+	// fractional values make the sums depend on the order of their reduction
+	Fill(x, cSizes, g, 50, 100000, true);
+	Fill(y, cSizes, g, 50, 100000, true);
+	for (const Features* t : { (const Features*)nullptr, &templ }) {
+		vector<ChromR> rs1, rs4;
+
+		Workers::SetCount(1);
+		x.FillChromRs(y, cIDs, t, t != nullptr, rs1);
+		Workers::SetCount(4);
+		x.FillChromRs(y, cIDs, t, t != nullptr, rs4);
+		for (size_t i = 0; i < cIDs.size(); i++) {
+			CheckSame(title, cIDs[i], rs1[i], rs4[i]);
+
+			ChromR r;
+			CalcChromR(x, y, cIDs[i], t, r.R, t ? &r.LocResults : nullptr);
+			Check(fabs(r.R.PCC() - rs1[i].R.PCC()) < 1e-6, title,
+				Chrom::AbbrName(cIDs[i]) + ": parallel " + to_string(rs1[i].R.PCC()) + " vs serial " + to_string(r.R.PCC()));
+			r.R = rs1[i].R;		// sums are reduced in another order
+			CheckSame(title, cIDs[i], r, rs1[i]);
+		}
+	}
+	Workers::SetCount(1);
+}
+
+// Compact layout gives the same coefficients as the plain one
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+//	@templ: template
+void TestPacked(const ChromSizes& cSizes, const vector<chrid>& cIDs, const Features& templ)
+{
+	const char* title = "PackedItems";
+	const size_t cnt = cIDs.size() + 1;
+
+	for (const Features* t : { (const Features*)nullptr, &templ }) {
+		mt19937 g(2);
+		TestCover x, y;
+		vector<float> ccs1(cnt), ccs2(cnt), ccs3(cnt);
+
+		Fill(x, cSizes, g, 300, 100000, true);
+		Fill(y, cSizes, g, 3000, 100000, true);
+		x.CalcR(y, cIDs, t, ccs1.data());
+		x.Pack();
+		x.CalcR(y, cIDs, t, ccs2.data());
+		y.Pack();
+		x.CalcR(y, cIDs, t, ccs3.data());
+		for (size_t i = 0; i < cnt; i++)
+			Check(Same(ccs1[i], ccs2[i]) && Same(ccs1[i], ccs3[i]), title,
+				to_string(i) + ": " + to_string(ccs1[i]) + " vs " + to_string(ccs2[i]) + ", " + to_string(ccs3[i]));
+	}
+}
+
+// Batch calculation gives the same results as the pairwise one for each compared cover
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+//	@templ: template
+void TestBatch(const ChromSizes& cSizes, const vector<chrid>& cIDs, const Features& templ)
+{
+	const char* title = "Batch";
+	const size_t cnt = 3;
+	mt19937 g(4);
+	TestCover x, ys[cnt];
+
+	// fractional values make the sums depend on the order of their accumulation
+	Fill(x, cSizes, g, 50, 100000, true);
+	for (auto& y : ys)
+		Fill(y, cSizes, g, 500, 100000, true);
+	for (int packed = 0; packed < 2; packed++) {
+		if (packed) {
+			x.Pack();
+			ys[1].Pack();
+		}
+		for (const Features* t : { (const Features*)nullptr, &templ })
+			for (const chrid cID : cIDs) {
+				vector<FeatureSpan> spans;
+				if (t)	SplitFeatures(*t, cID, spans);
+				// without template the whole chrom is treated at once
+				for (size_t s = 0; s < (t ? spans.size() : 1); s++) {
+					const FeatureSpan* fSpan = t ? &spans[s] : nullptr;
+					vector<AnyCursor> itYs;
+					vector<ChromR> rs(cnt);
+
+					for (const auto& y : ys)	itYs.emplace_back(y, cID);
+					if (x.IsPacked())
+						CalcChromRs(PlainCover::PackedCursor(x, cID), itYs, fSpan, t != nullptr, rs.data());
+					else
+						CalcChromRs(PlainCover::PlainCursor(x, cID), itYs, fSpan, t != nullptr, rs.data());
+					for (size_t i = 0; i < cnt; i++) {
+						ChromR r;
+						CalcChromR(x, ys[i], cID, fSpan, r.R, t ? &r.LocResults : nullptr);
+						CheckSame(title, cID, r, rs[i]);
+					}
+				}
+			}
+	}
+}
+
+// Template features lying inside a single interval of both covers are counted in the chrom totals:
+// the totals are the same as the brute-force ones, and differ from the former totals
+// that left such features out
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+//	@templ: template
+void TestTotals(const ChromSizes& cSizes, const vector<chrid>& cIDs, const Features& templ)
+{
+	const char* title = "Totals";
+	mt19937 g(3);
+	TestCover x, y;
+	vector<ChromR> rs;
+	vector<vector<ValPos>> itemsX, itemsY;
+
+	// the items are much longer than the features, so many features lie inside a single interval
+	for (const chrid cID : cIDs) {
+		itemsX.push_back(RandomItems(g, cSizes[cID], 400, 9));
+		itemsY.push_back(RandomItems(g, cSizes[cID], 400, 9));
+		x.Add(cID, itemsX.back());
+		y.Add(cID, itemsY.back());
+	}
+	x.FillChromRs(y, cIDs, &templ, false, rs);
+
+	for (size_t i = 0; i < cIDs.size(); i++) {
+		const chrlen cLen = cSizes[cIDs[i]];
+		const vector<double> valsX = Dense(itemsX[i], cLen), valsY = Dense(itemsY[i], cLen);
+		vector<bool> border(cLen + 1, false);	// true at the item boundaries of any cover
+		spR r, rOld;
+		size_t insideCnt = 0;					// number of features inside a single interval
+
+		for (const auto& items : { itemsX[i], itemsY[i] })
+			for (const auto& item : items)	border[item.Pos] = true;
+		const FeatureSpan fSpan(templ, cIDs[i]);
+		for (auto itF = fSpan.First; itF != fSpan.Last; itF++) {
+			const bool inside = find(border.begin() + itF->Start, border.begin() + itF->End + 1, true)
+				== border.begin() + itF->End + 1;
+			insideCnt += inside;
+			for (chrlen pos = itF->Start; pos < itF->End; pos++) {
+				r.AddVal(1, float(valsX[pos]), float(valsY[pos]));
+				if (!inside)	rOld.AddVal(1, float(valsX[pos]), float(valsY[pos]));
+			}
+		}
+		const string chr = Chrom::AbbrName(cIDs[i]);
+		const float cc = rs[i].R.PCC();
+		Check(insideCnt, title, chr + ": no features inside a single interval");
+		Check(fabs(cc - r.PCC()) < 1e-5, title, chr + ": " + to_string(cc) + " vs " + to_string(r.PCC()));
+		Check(fabs(cc - rOld.PCC()) > 1e-4, title, chr + ": " + to_string(cc) + " is the former total");
+	}
+}
+
+// Cover restored from the cache gives the same coefficients; the cache of another source is rejected
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+void TestCache(const ChromSizes& cSizes, const vector<chrid>& cIDs)
+{
+	const char* title = "Cache";
+	const char* fName = "test.cache.bedgraph";
+	const size_t cnt = cIDs.size() + 1;
+	mt19937 g(3);
+	TestCover x, y, z, w;
+	CacheKey key;
+	vector<float> ccs1(cnt), ccs2(cnt);
+
+	Fill(x, cSizes, g, 200, 100000, true);
+	Fill(y, cSizes, g, 200, 100000, true);
+	x.Write(fName);		// source file
+	if (!Check(key.Init(fName, cSizes, 0), title, "source is not accessible"))
+		return;
+	x.SaveCache(fName, key);
+	if (!Check(z.LoadCache(fName, key, eOInfo::NONE), title, "cache is not loaded"))
+		return;
+	Check(z.ItemsCount() == x.ItemsCount(), title, "different number of items");
+	x.CalcR(y, cIDs, nullptr, ccs1.data());
+	z.CalcR(y, cIDs, nullptr, ccs2.data());
+	for (size_t i = 0; i < cnt; i++)
+		Check(Same(ccs1[i], ccs2[i]), title, to_string(i) + ": " + to_string(ccs1[i]) + " vs " + to_string(ccs2[i]));
+
+	{	// genome of the same size with the swapped chrom lengths
+		ofstream file(G2Name);
+		for (size_t i = 0; i < ArrCnt(CLens); i++)
+			file << "chr" << i + 1 << TAB << CLens[i ^ (i < 2)] << LF;
+	}
+	const ChromSizes cSizes2(G2Name, true);
+	CacheKey key2;
+	Check(cSizes2.GenSize() == cSizes.GenSize(), title, "genome sizes differ");
+	if (Check(key2.Init(fName, cSizes2, 0), title, "source is not accessible"))
+		Check(!w.LoadCache(fName, key2, eOInfo::NONE), title, "cache of another genome is loaded");
+	Check(CacheKey::TmpFileName(fName) != async(launch::async, CacheKey::TmpFileName, string(fName)).get(),
+		title, "temporary names of the concurrent writers are the same");
+}
+
+// FeatureCover: the features are rasterized as [Start, End+1), as the joint ranges of the ordinary beds
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+//	@templ: features
+void TestFeatureCover(const ChromSizes& cSizes, const vector<chrid>& cIDs, const Features& templ)
+{
+	const char* title = "FeatureCover";
+	FeatureCover x(templ, cSizes);
+	TestCover y;
+	vector<float> ccs(cIDs.size() + 1);
+
+	for (const chrid cID : cIDs) {
+		const FeatureSpan fSpan(templ, cID);
+		vector<ValPos> items;
+
+		for (auto itF = fSpan.First; itF != fSpan.Last; itF++) {
+			items.emplace_back(itF->Start, 1.f);
+			items.emplace_back(itF->End + 1);
+		}
+		items.emplace_back(cSizes[cID]);
+		y.Add(cID, items);
+	}
+	x.CalcR(y, cIDs, nullptr, ccs.data());
+	for (size_t i = 0; i < ccs.size(); i++)
+		Check(ccs[i] > 1 - 1e-6, title, to_string(i) + ": " + to_string(ccs[i]));
+}
+
+// ParseFloat gives the same values as strtod, including leading blanks and garbage;
+// ParseUInt skips blanks and rejects fields without digits
+void TestParse()
+{
+	const char* title = "ParseFloat";
+	mt19937_64 g(4);
+	char buf[64];
+	vector<string> strs = { "0", "-0", "+1.5", "1.", ".5", "1e3", "nan", "inf", "0.000000000000000000000001",
+		" 1.5", "\t-2", " \t+.5e2", " nan", "", " ", "x", "-", "+", ".", "-.", "-x", "e5", "1x",
+		"0x1p3", "-0X10", "0x", "1.5.5", "--1" };
+
+	for (int i = 0; i < 100000; i++) {
+		double val = double(g() % 100000000) / pow(10, int(g() % 12));
+		if (g() % 5 == 0)	val = -val;
+		switch (i % 5) {
+		case 0:	sprintf(buf, "%d", int(g() % 100000));	break;
+		case 1:	sprintf(buf, "%.3f", val);	break;
+		case 2:	sprintf(buf, "%.17g", val);	break;
+		case 3:	sprintf(buf, "%.22f", val);	break;		// too many digits to be parsed directly
+		default: sprintf(buf, " \t%.6f\tx", val);
+		}
+		strs.push_back(buf);
+	}
+	for (const string& s : strs)
+		if (!Check(Same(ParseFloat(s.c_str()), float(strtod(s.c_str(), nullptr))), title, s))
+			break;
+
+	title = "ParseUInt";
+	chrlen val;
+	const char* s = " \t123\t7.5";
+	Check(ParseUInt(s, val) && val == 123 && *s == TAB, title, "leading blanks are not skipped");
+	for (const char* field : { "", " ", "-1", "\t.5" }) {
+		s = field;
+		Check(!ParseUInt(s, val), title, string("field '") + field + "' is accepted");
+	}
+}
+
+// Returns chrom's items cut at the given length
+//	@items: chrom's items
+//	@len: length of the cut chrom
+vector<ValPos> Cut(const vector<ValPos>& items, chrlen len)
+{
+	vector<ValPos> res;
+
+	for (const auto& item : items)
+		if (item.Pos < len)	res.push_back(item);
+	res.emplace_back(len);
+	return res;
+}
+
+// Pyramid: approximate coefficient lies within the bound of its deviation from the exact one;
+// pyramids of different lengths give the same as the pyramids of the covers cut at their common complete windows
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+void TestPyramid(const ChromSizes& cSizes, const vector<chrid>& cIDs)
+{
+	const char* title = "Pyramid";
+	mt19937 g(5);
+	TestCover x, y;
+
+	Fill(x, cSizes, g, 200, 20);
+	Fill(y, cSizes, g, 200, 20);
+	const PlainCover::Pyramid pyrX(x), pyrY(y);
+	for (const chrid cID : cIDs) {
+		spR exact;
+		CalcChromR(x, y, cID, (const Features*)nullptr, exact, nullptr);
+		for (BYTE level = 0; level < PlainCover::Pyramid::LevelCnt; level++) {
+			spR approx;
+			const double err = CalcChromR(pyrX, pyrY, cID, level, approx);
+			Check(fabs(exact.PCC() - approx.PCC()) <= approx.Deviation(err) + 1e-6, title,
+				Chrom::AbbrName(cID) + " level " + to_string(level) + ": " + to_string(approx.PCC())
+				+ " vs " + to_string(exact.PCC()));
+		}
+	}
+
+	for (const chrid cID : cIDs) {
+		const chrlen len2 = cSizes[cID] - 1234;		// length of the shorter cover
+		const vector<ValPos> itemsX = RandomItems(g, cSizes[cID], 200, 20), itemsY = RandomItems(g, len2, 200, 20);
+		TestCover x2, y2;
+
+		x2.Add(cID, itemsX);
+		y2.Add(cID, itemsY);
+		const PlainCover::Pyramid pyrX2(x2), pyrY2(y2);
+		for (BYTE level = 0; level < PlainCover::Pyramid::LevelCnt; level++) {
+			const chrlen winLen = PlainCover::Pyramid::WinLens[level];
+			const chrlen len = len2 / winLen * winLen;		// common complete windows
+			if (!len)	continue;
+			TestCover xCut, yCut;
+			spR approx, approxCut;
+
+			xCut.Add(cID, Cut(itemsX, len));
+			yCut.Add(cID, Cut(itemsY, len));
+			const PlainCover::Pyramid pyrXCut(xCut), pyrYCut(yCut);
+			const double err = CalcChromR(pyrX2, pyrY2, cID, level, approx);
+			const double errCut = CalcChromR(pyrXCut, pyrYCut, cID, level, approxCut);
+			Check(Same(approx.PCC(), approxCut.PCC()) && err == errCut, title,
+				Chrom::AbbrName(cID) + " level " + to_string(level) + " of different lengths: "
+				+ to_string(approx.PCC()) + " vs " + to_string(approxCut.PCC()));
+		}
+	}
+}
+
+// StrandCC: profile is the same as the coefficients of the shifted 5' densities
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+void TestStrandCC(ChromSizes& cSizes, const vector<chrid>& cIDs)
+{
+	const char* title = "StrandCC";
+	const chrlen maxShift = 300, readLen = 36;
+	mt19937 g(6);
+	ofstream file(RName);
+	vector<spR> rs(maxShift + 1);
+
+	for (const chrid cID : cIDs) {
+		const chrlen cLen = cSizes[cID];
+		vector<double> fwd(cLen, 0), rev(cLen, 0);	// 5' densities
+
+		for (chrlen pos = g() % 50; pos + readLen <= cLen; pos += 1 + g() % 50) {
+			const bool strand = g() % 2;
+			file << Chrom::AbbrName(cID) << TAB << pos << TAB << pos + readLen << "\tr\t0\t" << (strand ? '+' : '-') << LF;
+			if (strand)	fwd[pos]++;
+			else if (pos + readLen < cLen)	rev[pos + readLen]++;
+		}
+		for (chrlen d = 0; d <= maxShift; d++) {
+			double sumX = 0, sumY = 0, sumSqrX = 0, sumSqrY = 0, sumXY = 0;
+			for (chrlen i = 0; i + d < cLen; i++) {
+				const double x = fwd[i], y = rev[i + d];
+				sumX += x;	sumSqrX += x * x;
+				sumY += y;	sumSqrY += y * y;
+				sumXY += x * y;
+			}
+			rs[d].AddSums(cLen - d, sumX, sumSqrX, sumY, sumSqrY, sumXY);
+		}
+	}
+	file.close();
+
+	vector<float> ccs;
+	StrandCC(RName, cSizes, maxShift, eOInfo::NONE).CalcProfile(ccs);
+	if (!Check(ccs.size() == maxShift + 1, title, "wrong profile length"))	return;
+	for (chrlen d = 0; d <= maxShift; d++)
+		if (!Check(fabs(ccs[d] - rs[d].PCC()) < 1e-5, title,
+			"shift " + to_string(d) + ": " + to_string(ccs[d]) + " vs " + to_string(rs[d].PCC())))
+			break;
+}
+
+// Sliding window coefficients are the same as the ones calculated within each window
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+void TestWinR(const ChromSizes& cSizes, const vector<chrid>& cIDs)
+{
+	const char* title = "WCC";
+	const chrid cID = cIDs.back();
+	const chrlen cLen = cSizes[cID];
+	mt19937 g(7);
+
+	for (int t = 0; t < 4; t++) {
+		TestCover x, y;
+		const vector<ValPos> itemsX = RandomItems(g, cLen, t < 2 ? 30 : 3000, 9);
+		const vector<ValPos> itemsY = RandomItems(g, cLen, t < 2 ? 30 : 3000, 9);
+		const vector<double> valsX = Dense(itemsX, cLen), valsY = Dense(itemsY, cLen);
+		const chrlen winLen = 1000 + g() % 3000, step = 100 + g() % 500;
+		vector<pair<chrlen, float>> res;
+
+		x.Add(cID, itemsX);
+		y.Add(cID, itemsY);
+		if (t % 2) {
+			x.Pack();
+			CalcChromWinR(PlainCover::PackedCursor(x, cID), PlainCover::PlainCursor(y, cID), winLen, step, res);
+		}
+		else
+			CalcChromWinR(PlainCover::PlainCursor(x, cID), PlainCover::PlainCursor(y, cID), winLen, step, res);
+		const map<chrlen, float> ccs(res.begin(), res.end());
+
+		for (chrlen start = 0; start + winLen <= cLen; start += step) {
+			long double sumX = 0, sumY = 0, sumSqrX = 0, sumSqrY = 0, sumXY = 0;
+			for (chrlen i = start; i < start + winLen; i++) {
+				sumX += valsX[i];	sumSqrX += valsX[i] * valsX[i];
+				sumY += valsY[i];	sumSqrY += valsY[i] * valsY[i];
+				sumXY += valsX[i] * valsY[i];
+			}
+			const long double cov = winLen * sumXY - sumX * sumY;
+			const long double varX = winLen * sumSqrX - sumX * sumX, varY = winLen * sumSqrY - sumY * sumY;
+			const long double eps = 1e-6L * winLen * winLen;
+			if (fabsl(cov) < eps || fabsl(varX) < eps || fabsl(varY) < eps)	continue;	// borderline window
+
+			const auto it = ccs.find(start);
+			const float cc = float(cov / sqrtl(varX) / sqrtl(varY));
+			if (!Check(it != ccs.end() && fabs(it->second - cc) < 1e-4, title,
+				"window " + to_string(start) + ": " + (it == ccs.end() ? string("missed") : to_string(it->second))
+				+ " vs " + to_string(cc)))
+				break;
+		}
+	}
+}
+
+// Sums of bins are the same for each instruction set supported by the processor
+void TestBinSums()
+{
+	const char* title = "BinSums";
+	mt19937 g(8);
+
+	for (const size_t cnt : { 0, 3, 8, 13, 1001 }) {
+		vector<float> x(cnt), y(cnt);
+		// Adds the rest of the bins
+		auto addRest = [&](size_t i, BinSums& s) {
+			for (; i < cnt; i++) {
+				s.X += x[i];	s.SqrX += double(x[i]) * x[i];
+				s.Y += y[i];	s.SqrY += double(y[i]) * y[i];
+				s.XY += double(x[i]) * y[i];
+			}
+		};
+		BinSums s0;
+		spR r0, r;
+
+		for (size_t i = 0; i < cnt; i++)
+			x[i] = float(g() % 1000) / 7, y[i] = float(g() % 1000) / 3;
+		addRest(AddBinLanes(x.data(), y.data(), cnt, s0), s0);
+		r0.AddSums(cnt, s0.X, s0.SqrX, s0.Y, s0.SqrY, s0.XY);
+		AddBinSums(x.data(), y.data(), cnt, r);
+		Check(fabs(r.PCC() - r0.PCC()) < 1e-6, title,
+			to_string(cnt) + " bins: " + to_string(r.PCC()) + " vs " + to_string(r0.PCC()));
+#ifdef _SIMD_DISPATCH
+		for (BYTE level = 1; level <= SimdLevel(); level++) {
+			BinSums s;
+			addRest((level == 1 ? AddBinLanesAVX2 : AddBinLanesAVX512)(x.data(), y.data(), cnt, s), s);
+			Check(fabs(s.X - s0.X) <= 1e-12 * s0.X && fabs(s.SqrY - s0.SqrY) <= 1e-12 * s0.SqrY
+				&& fabs(s.XY - s0.XY) <= 1e-12 * s0.XY, title,
+				to_string(cnt) + " bins: instruction set " + to_string(level));
+		}
+#endif
+	}
+}
+
+// Store gives the same coefficients as the covers binned in memory
+//	@cSizes: chrom sizes
+//	@cIDs: chroms
+void TestBinStore(ChromSizes& cSizes, const vector<chrid>& cIDs)
+{
+	const char* title = "BinStore";
+	const short cnt = 5;
+	const chrlen binLen = 37;
+	char binOpt[] = "--bin", binVal[] = "37", prog[] = "bioCC";
+	mt19937 g(8);
+	vector<string> names;
+	vector<char*> fNames;
+
+	for (short i = 0; i < cnt; i++) {
+		TestCover cv;
+		if (i == 3)		// the sample of two long intervals in each chrom has uniform chunks
+			for (auto it = cSizes.cBegin(); it != cSizes.cEnd(); it++) {
+				const chrlen cLen = cSizes[CID(it)];
+				cv.Add(CID(it), { ValPos(0, float(1 + g() % 8)), ValPos(cLen / 5 * 4, float(1 + g() % 8)), ValPos(cLen) });
+			}
+		else
+			Fill(cv, cSizes, g, 500, 9);
+		names.push_back("test.sample" + to_string(i) + ".bedgraph");
+		cv.Write(names.back());
+	}
+	for (auto& name : names)	fNames.push_back(&name[0]);
+	char* argv[] = { prog, binOpt, binVal, fNames[0] };
+	if (!Check(Options::Parse(ArrCnt(argv), argv) > 0, title, "options are not parsed"))	return;
+
+	Workers::SetCount(3);
+	BinStore::Build(fNames.data(), cnt, cSizes, SName);
+	BinStore(SName).CalcR(nullptr, MName);
+	Workers::SetCount(1);
+
+	vector<unique_ptr<PlainCover>> cvs;
+	for (const auto& name : names) {
+		cvs.emplace_back(CreateCover(name.c_str(), cSizes));
+		cvs.back()->Bin(binLen, cSizes);
+	}
+
+	// matrices for each chrom and total
+	ifstream file(MName);
+	string line, title2;
+	int cmpCnt = 0;
+	while (getline(file, line)) {
+		if (line[0] == '#') {
+			title2 = line.substr(1);
+			getline(file, line);	// header
+			continue;
+		}
+		istringstream ss(line);
+		string name, val;
+		ss >> name;
+		const size_t i = find(names.begin(), names.end(), name) - names.begin();
+		if (!Check(i < names.size(), title, "unknown sample " + name))	return;
+		for (size_t j = 0; j < names.size() && ss >> val; j++) {
+			if (i == j)	continue;
+			spR r;
+			bool done = false;		// true if at least one chrom is presented in both samples
+			for (const chrid cID : cIDs)
+				if ((title2 == "total" || title2 == Chrom::AbbrName(cID))
+				&& cvs[i]->Binned()->Chroms().count(cID) && cvs[j]->Binned()->Chroms().count(cID)) {
+					spR chrR;
+					CalcChromR(*cvs[i]->Binned(), *cvs[j]->Binned(), cID, chrR);
+					r.Add(chrR);
+					done = true;
+				}
+			const float cc = done ? r.PCC() : Undef;
+			cmpCnt++;
+			if (val == sUNDEF)
+				Check(cc == Undef || isNaN(cc), title, title2 + ' ' + name + ": UNDEF vs " + to_string(cc));
+			else
+				Check(fabs(stof(val) - cc) < 2e-5, title, title2 + ' ' + name + ": " + val + " vs " + to_string(cc));
+		}
+	}
+	Check(cmpCnt, title, "matrix is empty");
+}
+
+int main()
+{
+	try {
+		{	// fixtures
+			ofstream file(GName);
+			for (size_t i = 0; i < ArrCnt(CLens); i++)
+				file << "chr" << i + 1 << TAB << CLens[i] << LF;
+		}
+		ChromSizes cSizes(GName, true);
+		vector<chrid> cIDs;
+		for (auto it = cSizes.cBegin(); it != cSizes.cEnd(); it++)
+			cIDs.push_back(CID(it));
+		{	// features of the first chrom are split into several spans
+			mt19937 g(9);
+			ofstream file(TName);
+			for (const chrid cID : cIDs)
+				for (chrlen start = g() % 100, end; (end = start + 1 + g() % 30) < cSizes[cID]; start = end + 2 + g() % 20)
+					file << Chrom::AbbrName(cID) << TAB << start << TAB << end << LF;
+		}
+		const Features templ(TName, &cSizes, false, eOInfo::NONE, false);
+
+		TestWorkers();
+		TestThreads(cSizes, cIDs, templ);
+		TestPacked(cSizes, cIDs, templ);
+		TestTotals(cSizes, cIDs, templ);
+		TestBatch(cSizes, cIDs, templ);
+		TestCache(cSizes, cIDs);
+		TestFeatureCover(cSizes, cIDs, templ);
+		TestParse();
+		TestPyramid(cSizes, cIDs);
+		TestStrandCC(cSizes, cIDs);
+		TestWinR(cSizes, cIDs);
+		TestBinSums();
+		TestBinStore(cSizes, cIDs);
+	}
+	catch (const Err& e)		{ FailCnt++; cerr << e.what() << LF; }
+	catch (const exception& e)	{ FailCnt++; cerr << e.what() << LF; }
+
+	cout << (FailCnt ? to_string(FailCnt) + " checks failed" : "all checks passed") << LF;
+	return FailCnt ? 1 : 0;
+}